@@ -0,0 +1,247 @@
+#include "bench.h"
+
+#include <math.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_RDTSC 1
+#endif
+
+#include "../src/memory/memory_management.h"
+#include "../src/utils/time_utils.h"
+
+#define BENCH_RUNS 31
+#define BENCH_MIN_RUN_NS (10 * NS_PER_MS)
+#define BENCH_CONFIRM_ATTEMPTS 2
+#define DEFAULT_REGRESSION_PERCENT 5.0
+#define NOISE_SIGMAS 3.0
+#define MAD_TO_SIGMA 1.4826  // MAD -> standard deviation for normal noise
+#define MEDIAN_ERROR 1.2533  // standard error of a median, in sigma * sqrt(n)
+#define DEFAULT_CORPORA_DIR "bench/corpora"
+
+volatile uintptr_t bench_sink;
+
+// Raw samples of one kernel, filled one run at a time.
+struct bench_samples {
+  const BenchKernel *kernel;
+  size_t iterations;
+  double ns[BENCH_RUNS];
+  double cycles[BENCH_RUNS];
+};
+
+typedef struct bench_samples BenchSamples;
+
+static inline uint64_t cycles(void) {
+#ifdef HAVE_RDTSC
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+static int compare_doubles(const void *a, const void *b) {
+  double x = *(const double *) a, y = *(const double *) b;
+  return (x > y) - (x < y);
+}
+
+static double median(double *values, size_t count) {
+  qsort(values, count, sizeof(double), compare_doubles);
+
+  return count % 2 ? values[count / 2] : (values[count / 2 - 1] + values[count / 2]) / 2.0;
+}
+
+// Median absolute deviation: a spread estimate that, like the median, a few
+// preempted runs cannot drag around.
+static double mad(const double *values, size_t count, double center) {
+  double deviations[BENCH_RUNS];
+
+  for (size_t i = 0; i < count; i++) deviations[i] = fabs(values[i] - center);
+
+  return median(deviations, count);
+}
+
+// Enough iterations per run to drown out timer overhead.
+static size_t calibrate(const BenchKernel *k) {
+  size_t iterations = 1;
+
+  for (;;) {
+    uint64_t start = monotonic_ns();
+    for (size_t i = 0; i < iterations; i++) k->op(k->ctx);
+    if (monotonic_ns() - start >= BENCH_MIN_RUN_NS) return iterations;
+    iterations *= 2;
+  }
+}
+
+// Round-robin over the kernels, one run each per round: a burst of
+// machine noise then costs every kernel one or two runs, which the median
+// discards, instead of landing on every run of one unlucky kernel.
+static void measure(BenchSamples *samples, size_t count) {
+  for (size_t s = 0; s < count; s++) samples[s].iterations = calibrate(samples[s].kernel);
+
+  for (size_t r = 0; r < BENCH_RUNS; r++) {
+    for (size_t s = 0; s < count; s++) {
+      const BenchKernel *k = samples[s].kernel;
+      size_t iterations = samples[s].iterations;
+
+      uint64_t start_ns = monotonic_ns();
+      uint64_t start_cycles = cycles();
+
+      for (size_t i = 0; i < iterations; i++) k->op(k->ctx);
+
+      samples[s].cycles[r] = (double) (cycles() - start_cycles) / (double) iterations;
+      samples[s].ns[r] = (double) (monotonic_ns() - start_ns) / (double) iterations;
+    }
+  }
+}
+
+// Median of the runs plus their MAD, so a comparison can tell a shift from
+// noise.
+static BenchResult summarize(BenchSamples *samples) {
+  BenchResult result = { .ns_per_op = median(samples->ns, BENCH_RUNS), .cycles_per_op = median(samples->cycles, BENCH_RUNS) };
+  result.ns_mad = mad(samples->ns, BENCH_RUNS, result.ns_per_op);
+
+  return result;
+}
+
+// Both over the threshold and outside the noise of the two medians: a
+// median of n runs is off by about 1.253 * sigma / sqrt(n).
+static bool regressed(const BenchResult *r, double base, double base_mad, double threshold) {
+  double delta = (r->ns_per_op - base) / base * 100.0;
+  double error = MEDIAN_ERROR * MAD_TO_SIGMA * hypot(r->ns_mad, base_mad) / sqrt(BENCH_RUNS);
+  double noise = NOISE_SIGMAS * error;
+
+  return delta > threshold && r->ns_per_op - base > noise;
+}
+
+// Baseline files are "name<TAB>ns_per_op<TAB>mad" lines; the MAD column is
+// optional (0 when missing).
+static bool baseline_lookup(FILE *baseline, const char *name, double *ns, double *ns_mad) {
+  char line[MAX_STRING_LENGTH];
+
+  rewind(baseline);
+
+  while (fgets(line, sizeof(line), baseline)) {
+    char *tab = strchr(line, '\t');
+    if (!tab) continue;
+
+    *tab = '\0';
+
+    if (strcmp(line, name) == 0) {
+      char *end = NULL;
+
+      *ns = strtod(tab + 1, &end);
+      *ns_mad = *end == '\t' ? strtod(end + 1, NULL) : 0.0;
+
+      return true;
+    }
+  }
+
+  return false;
+}
+
+static void usage(const char *program) {
+  fprintf(stderr, "Usage: %s [--save FILE | --compare FILE [--threshold PCT]] [--corpora DIR] [--filter SUBSTR]\n", program);
+}
+
+int main(int argc, char *argv[]) {
+  const char *save_path = NULL, *compare_path = NULL, *filter = NULL;
+  const char *corpora = DEFAULT_CORPORA_DIR;
+  double threshold = DEFAULT_REGRESSION_PERCENT;
+
+  for (int i = 1; i < argc; i++) {
+    bool has_value = i + 1 < argc;
+
+    if (strcmp(argv[i], "--save") == 0 && has_value) {
+      save_path = argv[++i];
+    } else if (strcmp(argv[i], "--compare") == 0 && has_value) {
+      compare_path = argv[++i];
+    } else if (strcmp(argv[i], "--threshold") == 0 && has_value) {
+      threshold = strtod(argv[++i], NULL);
+    } else if (strcmp(argv[i], "--corpora") == 0 && has_value) {
+      corpora = argv[++i];
+    } else if (strcmp(argv[i], "--filter") == 0 && has_value) {
+      filter = argv[++i];
+    } else {
+      usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  const BenchKernel *kernels;
+  size_t count = bench_kernels(&kernels, corpora);
+  if (count == 0) return EXIT_FAILURE;
+
+  BenchSamples *samples = mm_calloc(count, sizeof(BenchSamples));
+  if (!samples) return EXIT_FAILURE;
+
+  size_t selected = 0;
+
+  for (size_t i = 0; i < count; i++) {
+    if (!filter || strstr(kernels[i].name, filter)) samples[selected++].kernel = &kernels[i];
+  }
+
+  FILE *save = save_path ? fopen(save_path, "w") : NULL;
+  FILE *baseline = compare_path ? fopen(compare_path, "r") : NULL;
+
+  if ((save_path && !save) || (compare_path && !baseline)) {
+    fprintf(stderr, "bench: cannot open %s\n", save_path ? save_path : compare_path);
+    mm_free(samples);
+    return EXIT_FAILURE;
+  }
+
+  measure(samples, selected);
+
+  size_t regressions = 0;
+
+  printf("%-28s %12s %8s %12s %10s %10s\n", "kernel", "ns/op", "mad", "cycles/op", "cyc/byte", baseline ? "delta" : "");
+
+  for (size_t s = 0; s < selected; s++) {
+    const BenchKernel *k = samples[s].kernel;
+    BenchResult r = summarize(&samples[s]);
+    double base, base_mad;
+    bool compared = baseline && baseline_lookup(baseline, k->name, &base, &base_mad) && base > 0;
+    bool worse = compared && regressed(&r, base, base_mad, threshold);
+
+    // A suspected regression is measured again on its own; it only counts if
+    // every attempt agrees, and the fastest attempt is the one reported.
+    for (size_t attempt = 0; worse && attempt < BENCH_CONFIRM_ATTEMPTS; attempt++) {
+      measure(&samples[s], 1);
+
+      BenchResult again = summarize(&samples[s]);
+      if (again.ns_per_op < r.ns_per_op) r = again;
+
+      worse = regressed(&again, base, base_mad, threshold);
+    }
+
+    printf("%-28s %12.2f %7.1f%% %12.1f ", k->name, r.ns_per_op, r.ns_per_op > 0 ? r.ns_mad / r.ns_per_op * 100.0 : 0.0,
+           r.cycles_per_op);
+
+    if (k->bytes && r.cycles_per_op > 0) {
+      printf("%10.3f", r.cycles_per_op / (double) k->bytes);
+    } else {
+      printf("%10s", "-");
+    }
+
+    if (compared) {
+      printf(" %+9.1f%%%s", (r.ns_per_op - base) / base * 100.0, worse ? "  REGRESSION" : "");
+      regressions += worse;
+    }
+
+    printf("\n");
+
+    if (save) fprintf(save, "%s\t%.4f\t%.4f\n", k->name, r.ns_per_op, r.ns_mad);
+  }
+
+  mm_free(samples);
+
+  if (save) fclose(save);
+  if (baseline) fclose(baseline);
+
+  if (regressions) {
+    fprintf(stderr, "bench: %zu kernel(s) regressed by more than %.1f%% beyond run-to-run noise\n", regressions, threshold);
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "../src/common.h"
+
+// One benchmarked operation. `op` is called in a tight loop with `ctx`;
+// `bytes` is the input size per call (0 when cycles/byte is meaningless).
+struct bench_kernel {
+  const char *name;
+  void (*op)(const void *ctx);
+  const void *ctx;
+  size_t bytes;
+};
+
+typedef struct bench_kernel BenchKernel;
+
+struct bench_result {
+  double ns_per_op;      // median over the runs
+  double ns_mad;         // median absolute deviation of ns_per_op
+  double cycles_per_op;  // 0 where no cycle counter is available
+};
+
+typedef struct bench_result BenchResult;
+
+// Results are written here so the compiler cannot drop the work.
+extern volatile uintptr_t bench_sink;
+
+// Builds the corpora and returns the kernel table (kernels.c).
+size_t bench_kernels(const BenchKernel **kernels, const char *corpora_dir);
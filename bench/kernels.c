@@ -0,0 +1,149 @@
+#include "bench.h"
+
+#include "../src/env/parsers/url_parser.h"
+#include "../src/env/parsers/value_parser.h"
+#include "../src/errors/errors.h"
+#include "../src/memory/memory_management.h"
+#include "../old/src/cloudflare_ddns/utils/is_true.h"
+#include "../old/src/multithreaded_ip_getter/ip_utils.h"
+
+#define ZONE_LISTING_RECORDS 2000
+
+static char *provider_page = NULL;
+static char *zone_listing = NULL;
+
+static const char *URL_LIST = "ipinfo.io/ip,api.ipify.org/,ipv4.icanhazip.com/,checkip.amazonaws.com/,"
+                              "ifconfig.me/ip,icanhazip.com/,ident.me/,ipecho.net/plain";
+
+static const char *IPV4_CANDIDATES[] = { "203.0.113.57", "10.0.0.1", "255.255.255.255", "256.1.1.1", "1.2.3", "192.168.001.010" };
+
+static const char *BOOL_VALUES[] = { "true", "False", " yes ", "0", "ON", "maybe" };
+
+static char *read_file(const char *path) {
+  FILE *f = fopen(path, "rb");
+  if (!f) return NULL;
+
+  fseek(f, 0, SEEK_END);
+  long size = ftell(f);
+  rewind(f);
+
+  char *buffer = size >= 0 ? malloc((size_t) size + 1) : NULL;
+
+  if (buffer && fread(buffer, 1, (size_t) size, f) == (size_t) size) {
+    buffer[size] = '\0';
+  } else {
+    free(buffer);
+    buffer = NULL;
+  }
+
+  fclose(f);
+
+  return buffer;
+}
+
+// Shaped like a GET /zones/:id/dns_records page with `records` A records.
+static char *build_zone_listing(size_t records) {
+  char *buf = NULL;
+  size_t len = 0;
+  FILE *out = open_memstream(&buf, &len);
+  if (!out) return NULL;
+
+  fputs("{\"result\":[", out);
+
+  for (size_t i = 0; i < records; i++) {
+    fprintf(out,
+            "%s{\"id\":\"%032zx\",\"zone_id\":\"023e105f4ecef8ad9ca31a8372d0c353\",\"zone_name\":\"example.com\","
+            "\"name\":\"host-%zu.example.com\",\"type\":\"A\",\"content\":\"198.51.%zu.%zu\",\"proxiable\":true,"
+            "\"proxied\":%s,\"ttl\":1,\"locked\":false,\"meta\":{\"auto_added\":false,\"source\":\"primary\"},"
+            "\"comment\":null,\"tags\":[],\"created_on\":\"2024-01-%02zuT08:00:00.000000Z\","
+            "\"modified_on\":\"2025-05-%02zuT12:30:00.000000Z\"}",
+            i ? "," : "", i * 2654435761u, i, (i / 256) % 256, i % 256, i % 3 ? "false" : "true", i % 28 + 1, i % 30 + 1);
+  }
+
+  fprintf(out, "],\"success\":true,\"errors\":[],\"messages\":[],"
+               "\"result_info\":{\"page\":1,\"per_page\":%d,\"count\":%d,\"total_count\":%d,\"total_pages\":1}}",
+          ZONE_LISTING_RECORDS, ZONE_LISTING_RECORDS, ZONE_LISTING_RECORDS);
+
+  fclose(out);
+
+  return buf;
+}
+
+static void op_parse_urls(const void *ctx) {
+  MetaArray urls = parse_urls(ctx);
+  bench_sink += urls.length;
+  mm_free(urls.data);
+}
+
+static void op_is_valid_ipv4(const void *ctx) {
+  (void) ctx;
+
+  for (size_t i = 0; i < ARRAY_SIZE(IPV4_CANDIDATES); i++) bench_sink += is_valid_ipv4(IPV4_CANDIDATES[i]);
+}
+
+static void op_extract_first_ipv4(const void *ctx) {
+  char *ip = extract_first_ipv4(ctx);
+  bench_sink += (uintptr_t) ip;
+  free(ip);
+}
+
+static void op_strip_noise(const void *ctx) {
+  char *clean = strip_noise(ctx);
+  bench_sink += (uintptr_t) clean;
+  free(clean);
+}
+
+static void op_error_matches_any(const void *ctx) {
+  (void) ctx;
+
+  bench_sink += error_matches_any(ERR_INVALID_ENV_DOMAINS, ERR_INVALID_ENV_PROXIED, ERR_PARSE, ERR_RELOAD, ERR_NONE);
+}
+
+static void op_to_bool(const void *ctx) {
+  (void) ctx;
+
+  for (size_t i = 0; i < ARRAY_SIZE(BOOL_VALUES); i++) bench_sink += to_bool(BOOL_VALUES[i]);
+}
+
+static void op_parse_bool(const void *ctx) {
+  (void) ctx;
+  bool value;
+
+  for (size_t i = 0; i < ARRAY_SIZE(BOOL_VALUES); i++) bench_sink += parse_bool(BOOL_VALUES[i], &value) && value;
+}
+
+// The only JSON extraction the client does today (old/src/*/main.c).
+static void op_response_success(const void *ctx) {
+  bench_sink += (uintptr_t) strstr(ctx, "\"success\":true");
+}
+
+size_t bench_kernels(const BenchKernel **out, const char *corpora_dir) {
+  static BenchKernel kernels[8];
+
+  char path[MAX_STRING_LENGTH];
+  snprintf(path, sizeof(path), "%s/provider_page.html", corpora_dir);
+
+  if (!provider_page) provider_page = read_file(path);
+  if (!zone_listing) zone_listing = build_zone_listing(ZONE_LISTING_RECORDS);
+
+  if (!provider_page || !zone_listing) {
+    fprintf(stderr, "bench: cannot load corpora from %s\n", corpora_dir);
+    return 0;
+  }
+
+  const BenchKernel table[ARRAY_SIZE(kernels)] = {
+      { "parse_urls", op_parse_urls, URL_LIST, strlen(URL_LIST) },
+      { "is_valid_ipv4 x6", op_is_valid_ipv4, NULL, 0 },
+      { "extract_first_ipv4/html", op_extract_first_ipv4, provider_page, strlen(provider_page) },
+      { "strip_noise/plain", op_strip_noise, " 203.0.113.57\n", 14 },
+      { "error_matches_any", op_error_matches_any, NULL, 0 },
+      { "to_bool x6", op_to_bool, NULL, 0 },
+      { "parse_bool x6", op_parse_bool, NULL, 0 },
+      { "success_scan/zones", op_response_success, zone_listing, strlen(zone_listing) },
+  };
+
+  memcpy(kernels, table, sizeof(table));
+  *out = kernels;
+
+  return ARRAY_SIZE(kernels);
+}
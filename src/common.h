@@ -22,6 +22,60 @@
 // Defaults values
 #define DEFAULT_MINUTES_BETWEEN_UPDATES 15
 #define DEFAULT_PROPAGATION_DELAY_SECONDS 60
+#define DEFAULT_PROXIED "false"
+#define DEFAULT_LOG_LEVEL "INFO"
+#define DEFAULT_IP_V4_APIS "ipinfo.io/ip,api.ipify.org/,ipv4.icanhazip.com/"
+#define DEFAULT_METRICS_LISTEN ""
+#define DEFAULT_CYCLE_BUDGET_SECONDS 30
+#define DEFAULT_CONTROL_SOCKET ""
+#define DEFAULT_DETECTION_GROUP_DIR ""
+#define DEFAULT_IP_SNAPSHOT_PATH ""
+#define DEFAULT_STATE_MAX_AGE_MINUTES 1440
+
+// Accepted ranges
+#define MIN_MINUTES_BETWEEN_UPDATES 1
+#define MAX_MINUTES_BETWEEN_UPDATES 1440
+#define MAX_PROPAGATION_DELAY_SECONDS 3600
+#define MIN_CYCLE_BUDGET_SECONDS 1
+#define MAX_CYCLE_BUDGET_SECONDS 3600
+#define MAX_STATE_MAX_AGE_MINUTES 10080
+
+// Startup validation
+#define REMOTE_CHECK_TIMEOUT_MS 5000
+#define REMOTE_CHECK_MAX_THREADS 8
+#define HTTPS_PORT "443"
+
+// Metrics endpoint
+#define METRICS_UNIX_PREFIX "unix:"
+#define METRICS_MAX_REQUEST_SIZE 1024
+#define METRICS_MAX_CLIENTS 16
+#define METRICS_CLIENT_TIMEOUT_MS 5000
+
+// Worker pool
+#define TASK_POOL_MAX_WORKERS 16
+#define TASK_POOL_DEQUE_CAPACITY 1024  // power of two
+
+// Shutdown
+#define SHUTDOWN_DRAIN_SECONDS 10
+
+// Slow-cycle reports
+#define CYCLE_BUDGET_MAX_CHARGES 256
+#define CYCLE_BUDGET_REPORT_TOP 8
+
+// Fleet scheduling
+#define MACHINE_ID_PATH "/etc/machine-id"
+#define STARTUP_SPREAD_SECONDS 30
+#define NETLINK_SPREAD_SECONDS 10
+
+// Detection groups
+#define DETECTION_GROUP_LOCK_FILE "leader.lock"
+#define DETECTION_GROUP_IP_FILE "public_ip"
+
+// Persistent state
+#define DEFAULT_STATE_DIRECTORY "/var/lib/cloudflare-ddns"
+#define LATENCY_STATE_FILE "latency.hdr"
+#define UPDATE_STATE_FILE "state.bin"
+#define STATE_ID_SIZE 64  // Cloudflare ids are 32 hex characters
 
 // Environments variables
 #define CLOUDFLARE_API_KEY_ENV_VAR "CLOUDFLARE_API_KEY"
@@ -30,13 +84,30 @@
 #define MINUTES_BETWEEN_UPDATES_ENV_VAR "MINUTES_BETWEEN_UPDATES"
 #define PROPAGATION_DELAY_SECONDS_ENV_VAR "PROPAGATION_DELAY_SECONDS"
 #define IP_V4_APIS_ENV_VAR "IP_V4_APIS"
+#define LOG_LEVEL_ENV_VAR "LOG_LEVEL"
+#define METRICS_LISTEN_ENV_VAR "METRICS_LISTEN"
+#define CYCLE_BUDGET_SECONDS_ENV_VAR "CYCLE_BUDGET_SECONDS"
+#define CONTROL_SOCKET_ENV_VAR "CONTROL_SOCKET"
+#define DETECTION_GROUP_DIR_ENV_VAR "DETECTION_GROUP_DIR"
+#define IP_SNAPSHOT_PATH_ENV_VAR "IP_SNAPSHOT_PATH"
+#define STATE_MAX_AGE_MINUTES_ENV_VAR "STATE_MAX_AGE_MINUTES"
+#define ENV_FILE_ENV_VAR "ENV_FILE"
+#define CLOUDFLARE_API_KEY_FILE_ENV_VAR "CLOUDFLARE_API_KEY_FILE"
+#define CLOUDFLARE_API_KEY_FD_ENV_VAR "CLOUDFLARE_API_KEY_FD"
+#define CREDENTIALS_DIRECTORY_ENV_VAR "CREDENTIALS_DIRECTORY"
+#define CLOUDFLARE_API_KEY_CREDENTIAL "cloudflare_api_key"
+#define STATE_DIRECTORY_ENV_VAR "STATE_DIRECTORY"
+#define HOST_ID_ENV_VAR "HOST_ID"
 
 // Delimiters and constants
 #define DOMAIN_DELIMITER ','
 #define MAX_STRING_LENGTH 1024
 #define MAX_ARRAY_SIZE 100
+#define IPV4_STRING_SIZE 16
 
 // Useful macros
 #define ARRAY_SIZE(arr) (sizeof(arr) / sizeof((arr)[0]))
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
 #define MAX(a, b) ((a) > (b) ? (a) : (b))
+#define STRINGIFY_(x) #x
+#define STRINGIFY(x) STRINGIFY_(x)
@@ -0,0 +1,326 @@
+#define _GNU_SOURCE  // accept4
+
+#include "control.h"
+
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../memory/memory_management.h"
+#include "../metrics/metrics.h"
+#include "../tracing/trace.h"
+#include "../utils/time_utils.h"
+#include "daemon.h"
+
+#define CONTROL_COMMAND_SIZE 64
+#define CONTROL_BACKLOG 8
+#define CONTROL_MAX_CLIENTS 8
+#define CONTROL_CLIENT_TIMEOUT_MS 5000
+#define CONTROL_SOCKET_MODE 0660
+
+struct control_client {
+  EventSource source;
+  ControlServer *server;
+  struct control_client *prev;
+  struct control_client *next;
+  WheelTimer timeout;
+
+  char *reply;  // NULL while the command is still being read
+  size_t length;
+  size_t sent;
+
+  size_t used;
+  char buffer[CONTROL_COMMAND_SIZE];
+};
+
+typedef struct control_client ControlClient;
+
+static bool dump_metrics(void *ctx, FILE *reply) {
+  (void) ctx;
+  size_t length;
+
+  char *text = metrics_render(&length);
+  if (!text) return false;
+
+  fwrite(text, 1, length, reply);
+  free(text);
+
+  return true;
+}
+
+#ifdef ENABLE_TRACING
+static bool dump_trace(void *ctx, FILE *reply) {
+  (void) ctx;
+
+  return trace_dump(reply);
+}
+#else
+#define dump_trace NULL
+#endif
+
+// NULL handler = command not available in this build.
+static control_command_fn find_command(const ControlServer *server, const char *name) {
+  const struct {
+    const char *name;
+    control_command_fn fn;
+  } commands[] = {
+      { "trigger-now", server->handlers.trigger_now },
+      { "status", server->handlers.status },
+      { "flush-caches", server->handlers.flush_caches },
+      { "dump-metrics", dump_metrics },
+      { "dump-trace", dump_trace },
+      { "reload", server->handlers.reload },
+  };
+
+  for (size_t i = 0; i < ARRAY_SIZE(commands); i++) {
+    if (strcmp(commands[i].name, name) == 0) return commands[i].fn;
+  }
+
+  return NULL;
+}
+
+static void send_all(int fd, const char *data, size_t length) {
+  while (length > 0) {
+    ssize_t n = send(fd, data, length, MSG_NOSIGNAL);
+
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return;
+    }
+
+    data += n;
+    length -= (size_t) n;
+  }
+}
+
+static void close_client(ControlClient *client) {
+  ControlServer *server = client->server;
+
+  if (client->prev) {
+    client->prev->next = client->next;
+  } else {
+    server->clients = client->next;
+  }
+
+  if (client->next) client->next->prev = client->prev;
+  server->client_count--;
+
+  daemon_timer_cancel(&client->timeout);
+  event_loop_remove(server->loop, &client->source);
+  close(client->source.fd);
+  free(client->reply);
+  mm_free(client);
+}
+
+// Runs the command and builds the whole answer (status line, then payload)
+// in memory; it is then written out as the socket accepts it.
+static bool execute(ControlClient *client, const char *command) {
+  char *payload = NULL;
+  size_t payload_len = 0;
+  bool ok = false;
+
+  control_command_fn fn = find_command(client->server, command);
+  FILE *reply = open_memstream(&payload, &payload_len);
+
+  if (fn && reply) ok = fn(client->server->handlers.ctx, reply);
+  if (reply) fclose(reply);
+
+  const char *status = ok ? "ok\n" : fn ? "error command failed\n" : "error unknown command\n";
+  size_t status_len = strlen(status);
+
+  client->reply = malloc(status_len + (payload ? payload_len : 0));
+
+  if (client->reply) {
+    memcpy(client->reply, status, status_len);
+    if (payload) memcpy(client->reply + status_len, payload, payload_len);
+    client->length = status_len + (payload ? payload_len : 0);
+  }
+
+  free(payload);
+
+  return client->reply != NULL;
+}
+
+// False once the connection is finished (fully sent or failed).
+static bool send_pending(ControlClient *client) {
+  while (client->sent < client->length) {
+    ssize_t n = send(client->source.fd, client->reply + client->sent, client->length - client->sent, MSG_NOSIGNAL);
+
+    if (n < 0) return errno == EAGAIN || errno == EINTR;
+
+    client->sent += (size_t) n;
+  }
+
+  return false;
+}
+
+static void on_client(EventSource *source, uint32_t events) {
+  ControlClient *client = source->ctx;
+
+  if (client->reply) {
+    if (!send_pending(client) || (events & EPOLLERR)) close_client(client);
+    return;
+  }
+
+  ssize_t n = recv(source->fd, client->buffer + client->used, sizeof(client->buffer) - 1 - client->used, 0);
+
+  if (n < 0 && (errno == EAGAIN || errno == EINTR)) return;
+
+  if (n <= 0 || (events & (EPOLLERR | EPOLLHUP))) {
+    close_client(client);
+    return;
+  }
+
+  client->used += (size_t) n;
+  client->buffer[client->used] = '\0';
+
+  char *newline = strchr(client->buffer, '\n');
+
+  if (!newline && client->used < sizeof(client->buffer) - 1) return;
+
+  if (newline) {
+    *newline = '\0';
+    if (newline > client->buffer && newline[-1] == '\r') newline[-1] = '\0';
+  }
+
+  // A large answer (dump-metrics) that does not fit in the socket buffer is
+  // finished on EPOLLOUT, so a slow reader never holds the loop.
+  if (execute(client, newline ? client->buffer : "") && send_pending(client) &&
+      event_loop_modify(client->server->loop, source, EPOLLOUT)) {
+    return;
+  }
+
+  close_client(client);
+}
+
+static void on_timeout(WheelTimer *timer) { close_client(timer->ctx); }
+
+static void on_accept(EventSource *source, uint32_t events) {
+  (void) events;
+  ControlServer *server = source->ctx;
+
+  int fd = accept4(source->fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+  if (fd < 0) return;
+
+  // At the limit the oldest connection makes room, so clients that never
+  // finish their command cannot pile up descriptors.
+  if (server->client_count >= CONTROL_MAX_CLIENTS) close_client(server->clients);
+
+  ControlClient *client = mm_calloc(1, sizeof(ControlClient));
+
+  if (!client) {
+    close(fd);
+    return;
+  }
+
+  client->server = server;
+  client->timeout = (WheelTimer) { .callback = on_timeout, .ctx = client };
+  client->source = (EventSource) { .fd = fd, .handler = on_client, .ctx = client };
+
+  if (!event_loop_add(server->loop, &client->source, EPOLLIN | EPOLLRDHUP)) {
+    close(fd);
+    mm_free(client);
+    return;
+  }
+
+  daemon_timer_schedule(&client->timeout, CONTROL_CLIENT_TIMEOUT_MS * NS_PER_MS);
+
+  // Appended, so the list stays oldest first.
+  ControlClient **tail = &server->clients;
+  ControlClient *prev = NULL;
+
+  while (*tail) {
+    prev = *tail;
+    tail = &prev->next;
+  }
+
+  client->prev = prev;
+  *tail = client;
+  server->client_count++;
+}
+
+bool control_server_open(ControlServer *server, EventLoop *loop, const char *path, const ControlHandlers *handlers) {
+  struct sockaddr_un addr = { .sun_family = AF_UNIX };
+
+  server->loop = loop;
+  server->handlers = *handlers;
+  server->listener = (EventSource) { .fd = -1, .handler = on_accept, .ctx = server };
+  server->clients = NULL;
+  server->client_count = 0;
+  server->path[0] = '\0';
+
+  if (strlen(path) >= sizeof(addr.sun_path)) return false;
+  strcpy(addr.sun_path, path);
+
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd < 0) return false;
+
+  unlink(path);
+
+  if (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) != 0 || chmod(path, CONTROL_SOCKET_MODE) != 0 ||
+      listen(fd, CONTROL_BACKLOG) != 0) {
+    close(fd);
+    return false;
+  }
+
+  server->listener.fd = fd;
+  snprintf(server->path, sizeof(server->path), "%s", path);
+
+  if (!event_loop_add(loop, &server->listener, EPOLLIN)) {
+    control_server_close(server);
+    return false;
+  }
+
+  return true;
+}
+
+void control_server_close(ControlServer *server) {
+  while (server->clients) close_client(server->clients);
+
+  if (server->listener.fd < 0) return;
+
+  event_loop_remove(server->loop, &server->listener);
+  close(server->listener.fd);
+  server->listener.fd = -1;
+
+  if (server->path[0]) unlink(server->path);
+  server->path[0] = '\0';
+}
+
+int control_request(const char *path, const char *command, FILE *out) {
+  struct sockaddr_un addr = { .sun_family = AF_UNIX };
+
+  if (strlen(path) >= sizeof(addr.sun_path)) return EXIT_FAILURE;
+  strcpy(addr.sun_path, path);
+
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) return EXIT_FAILURE;
+
+  if (connect(fd, (struct sockaddr *) &addr, sizeof(addr)) != 0) {
+    fprintf(stderr, "%s: %s\n", path, strerror(errno));
+    close(fd);
+    return EXIT_FAILURE;
+  }
+
+  char line[CONTROL_COMMAND_SIZE];
+  int len = snprintf(line, sizeof(line), "%s\n", command);
+  send_all(fd, line, (size_t) MIN(len, (int) sizeof(line) - 1));
+
+  char buffer[4096];
+  bool first = true, ok = false;
+  ssize_t n;
+
+  while ((n = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+    if (first) {
+      ok = n >= 2 && memcmp(buffer, "ok", 2) == 0;
+      first = false;
+    }
+
+    fwrite(buffer, 1, (size_t) n, out);
+  }
+
+  close(fd);
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
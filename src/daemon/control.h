@@ -0,0 +1,50 @@
+#pragma once
+
+#include <sys/un.h>
+
+#include "../common.h"
+#include "event_loop.h"
+
+// Line protocol over a Unix stream socket: the client sends one command
+// terminated by '\n'; the daemon answers "ok" or "error <reason>" on the
+// first line, then any payload, and closes the connection. Clients are
+// served from the event loop without blocking it; a connection still open
+// after a few seconds is dropped, and only a handful are kept at once.
+//
+//   echo trigger-now | socat - UNIX-CONNECT:/run/cloudflare-ddns/control.sock
+
+// Writes its payload (if any) to `reply`; false makes the answer "error".
+typedef bool (*control_command_fn)(void *ctx, FILE *reply);
+
+struct control_handlers {
+  control_command_fn trigger_now;
+  control_command_fn status;
+  control_command_fn flush_caches;
+  control_command_fn reload;
+  void *ctx;
+};
+
+typedef struct control_handlers ControlHandlers;
+
+struct control_client;
+
+struct control_server {
+  EventLoop *loop;
+  EventSource listener;
+  ControlHandlers handlers;
+  struct control_client *clients;  // oldest first
+  size_t client_count;
+  char path[sizeof(((struct sockaddr_un *) 0)->sun_path)];
+};
+
+typedef struct control_server ControlServer;
+
+// Binds `path` (replacing a stale socket) and registers it with `loop`.
+bool control_server_open(ControlServer *server, EventLoop *loop, const char *path, const ControlHandlers *handlers);
+
+// Drops any client still connected and removes the socket file.
+void control_server_close(ControlServer *server);
+
+// Client side: sends `command`, copies the answer to `out`. Returns an exit
+// code (EXIT_SUCCESS when the daemon answered "ok").
+int control_request(const char *path, const char *command, FILE *out);
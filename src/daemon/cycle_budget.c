@@ -0,0 +1,157 @@
+#include "cycle_budget.h"
+
+#include "../logging/log.h"
+#include "../metrics/metrics.h"
+#include "../tracing/probes.h"
+#include "../utils/time_utils.h"
+
+// A (phase, subject) pair with its retries folded in.
+struct budget_consumer {
+  trace_phase_t phase;
+  const char *subject;
+  uint64_t total_ns;
+  unsigned int attempts;
+};
+
+typedef struct budget_consumer BudgetConsumer;
+
+// Set for the duration of a cycle; a span ending outside one is not charged.
+static _Atomic(CycleBudget *) active_budget = NULL;
+
+void cycle_budget_begin(CycleBudget *budget, unsigned int cycle, unsigned int budget_seconds) {
+  budget->cycle = cycle;
+  budget->budget_ns = (uint64_t) budget_seconds * NS_PER_SEC;
+  budget->duration_ns = 0;
+
+  for (size_t i = 0; i < TRACE_PHASE_COUNT; i++) atomic_store_explicit(&budget->phase_ns[i], 0, memory_order_relaxed);
+  atomic_store_explicit(&budget->length, 0, memory_order_relaxed);
+
+  PROBE_CYCLE_START(cycle);
+
+  budget->start_ns = monotonic_ns();
+  atomic_store_explicit(&active_budget, budget, memory_order_release);
+}
+
+void cycle_budget_charge(CycleBudget *budget, trace_phase_t phase, const char *subject, uint64_t duration_ns) {
+  atomic_fetch_add_explicit(&budget->phase_ns[phase], duration_ns, memory_order_relaxed);
+
+  size_t slot = atomic_fetch_add_explicit(&budget->length, 1, memory_order_relaxed);
+  if (slot >= CYCLE_BUDGET_MAX_CHARGES) return;
+
+  BudgetCharge *charge = &budget->charges[slot];
+
+  charge->phase = phase;
+  charge->duration_ns = duration_ns;
+  snprintf(charge->subject, sizeof(charge->subject), "%s", subject ? subject : "");
+}
+
+BudgetSpan budget_span_begin(trace_phase_t phase) {
+  BudgetSpan span = { .phase = phase, .start_ns = monotonic_ns() };
+  return span;
+}
+
+void budget_span_end(const BudgetSpan *span, const char *subject) {
+  uint64_t end_ns = monotonic_ns();
+
+#ifdef ENABLE_TRACING
+  TraceSpan trace = { .phase = span->phase, .start_ns = span->start_ns };
+  trace_span_end(&trace);
+#endif
+
+  CycleBudget *budget = atomic_load_explicit(&active_budget, memory_order_acquire);
+  if (budget) cycle_budget_charge(budget, span->phase, subject, end_ns - span->start_ns);
+}
+
+static int compare_consumers(const void *a, const void *b) {
+  uint64_t x = ((const BudgetConsumer *) a)->total_ns, y = ((const BudgetConsumer *) b)->total_ns;
+  return (x < y) - (x > y);
+}
+
+// Only runs for slow cycles, so the quadratic grouping is fine.
+static size_t group_charges(const CycleBudget *budget, BudgetConsumer *consumers) {
+  size_t length = MIN(atomic_load_explicit(&budget->length, memory_order_relaxed), (size_t) CYCLE_BUDGET_MAX_CHARGES);
+  size_t groups = 0;
+
+  for (size_t i = 0; i < length; i++) {
+    const BudgetCharge *charge = &budget->charges[i];
+    size_t g = 0;
+
+    while (g < groups && (consumers[g].phase != charge->phase || strcmp(consumers[g].subject, charge->subject) != 0)) g++;
+
+    if (g == groups) {
+      consumers[groups++] = (BudgetConsumer) { .phase = charge->phase, .subject = charge->subject };
+    }
+
+    consumers[g].total_ns += charge->duration_ns;
+    consumers[g].attempts++;
+  }
+
+  qsort(consumers, groups, sizeof(BudgetConsumer), compare_consumers);
+
+  return groups;
+}
+
+static void write_json_string(FILE *out, const char *str) {
+  fputc('"', out);
+
+  for (const unsigned char *c = (const unsigned char *) str; *c; c++) {
+    if (*c == '"' || *c == '\\') {
+      fprintf(out, "\\%c", *c);
+    } else if (*c < 0x20) {
+      fprintf(out, "\\u%04x", *c);
+    } else {
+      fputc(*c, out);
+    }
+  }
+
+  fputc('"', out);
+}
+
+static void write_report(const CycleBudget *budget, const BudgetConsumer *consumers, size_t groups, FILE *out) {
+  size_t charges = atomic_load_explicit(&budget->length, memory_order_relaxed);
+
+  fprintf(out, "{\"event\":\"slow_cycle\",\"cycle\":%u,\"duration_ms\":%.1f,\"budget_ms\":%.1f,\"phases_ms\":{",
+          budget->cycle, (double) budget->duration_ns / NS_PER_MS, (double) budget->budget_ns / NS_PER_MS);
+
+  bool first = true;
+
+  for (size_t p = 0; p < TRACE_PHASE_COUNT; p++) {
+    uint64_t ns = atomic_load_explicit(&budget->phase_ns[p], memory_order_relaxed);
+    if (!ns) continue;
+
+    fprintf(out, "%s\"%s\":%.1f", first ? "" : ",", trace_phase_name(p), (double) ns / NS_PER_MS);
+    first = false;
+  }
+
+  fprintf(out, "},\"top\":[");
+
+  for (size_t i = 0; i < MIN(groups, (size_t) CYCLE_BUDGET_REPORT_TOP); i++) {
+    fprintf(out, "%s{\"phase\":\"%s\",\"subject\":", i ? "," : "", trace_phase_name(consumers[i].phase));
+    write_json_string(out, consumers[i].subject);
+    fprintf(out, ",\"ms\":%.1f,\"attempts\":%u}", (double) consumers[i].total_ns / NS_PER_MS, consumers[i].attempts);
+  }
+
+  fprintf(out, "],\"charges\":%zu,\"charges_dropped\":%zu}\n", charges,
+          charges > CYCLE_BUDGET_MAX_CHARGES ? charges - CYCLE_BUDGET_MAX_CHARGES : 0);
+  fflush(out);
+}
+
+bool cycle_budget_end(CycleBudget *budget, FILE *report) {
+  atomic_store_explicit(&active_budget, NULL, memory_order_release);
+  budget->duration_ns = monotonic_ns() - budget->start_ns;
+
+  metrics_observe_cycle(budget->duration_ns);
+  PROBE_CYCLE_END(budget->cycle, budget->duration_ns);
+
+  if (budget->duration_ns <= budget->budget_ns) return false;
+
+  BudgetConsumer consumers[CYCLE_BUDGET_MAX_CHARGES];
+  size_t groups = group_charges(budget, consumers);
+
+  LOG(LOG_MSG_SLOW_CYCLE, groups ? consumers[0].subject : "(nothing charged)", budget->cycle,
+      budget->duration_ns / NS_PER_MS, budget->budget_ns / NS_PER_MS);
+
+  if (report) write_report(budget, consumers, groups, report);
+
+  return true;
+}
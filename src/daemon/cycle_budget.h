@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stdatomic.h>
+
+#include "../common.h"
+#include "../tracing/trace.h"
+
+#define CYCLE_BUDGET_SUBJECT_SIZE 64
+
+// One timed step: a provider request, a DNS lookup, a handshake, an API call.
+// Every retry is charged separately and folded together in the report.
+struct budget_charge {
+  trace_phase_t phase;
+  uint64_t duration_ns;
+  char subject[CYCLE_BUDGET_SUBJECT_SIZE];
+};
+
+typedef struct budget_charge BudgetCharge;
+
+// Time accounting for one update cycle. Workers charge concurrently; the
+// cycle owner reads everything in cycle_budget_end(), after they are done.
+struct cycle_budget {
+  unsigned int cycle;
+  uint64_t budget_ns;
+  uint64_t start_ns;
+  uint64_t duration_ns;
+  _Atomic uint64_t phase_ns[TRACE_PHASE_COUNT];
+  atomic_size_t length;  // may exceed CYCLE_BUDGET_MAX_CHARGES: overflow is still timed per phase
+  BudgetCharge charges[CYCLE_BUDGET_MAX_CHARGES];
+};
+
+typedef struct cycle_budget CycleBudget;
+
+// Also makes `budget` the active one (see budget_span_end()) until
+// cycle_budget_end().
+void cycle_budget_begin(CycleBudget *budget, unsigned int cycle, unsigned int budget_seconds);
+
+void cycle_budget_charge(CycleBudget *budget, trace_phase_t phase, const char *subject, uint64_t duration_ns);
+
+// One timed step, from any thread:
+//
+//   BudgetSpan span = budget_span_begin(TRACE_CONNECT);
+//   connect(...);
+//   budget_span_end(&span, url);
+//
+// charges the cycle in progress, if any, and in builds with -DENABLE_TRACING
+// also records the step as a trace span.
+struct budget_span {
+  trace_phase_t phase;
+  uint64_t start_ns;
+};
+
+typedef struct budget_span BudgetSpan;
+
+BudgetSpan budget_span_begin(trace_phase_t phase);
+
+void budget_span_end(const BudgetSpan *span, const char *subject);
+
+// Closes the cycle (metrics, probes). When it ran over budget, logs a one-line
+// summary and, if `report` is set, writes the full report there as a single
+// JSON line. Returns whether the cycle was slow.
+bool cycle_budget_end(CycleBudget *budget, FILE *report);
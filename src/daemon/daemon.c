@@ -0,0 +1,766 @@
+#include "daemon.h"
+
+#include <arpa/inet.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include "../env/config_check.h"
+#include "../logging/log.h"
+#include "../metrics/latency_store.h"
+#include "../metrics/metrics.h"
+#include "../metrics/metrics_server.h"
+#include "../signals/signal_processing.h"
+#include "../state/state_file.h"
+#include "../utils/time_utils.h"
+#include "control.h"
+#include "detection_group.h"
+#include "event_loop.h"
+#include "ip_snapshot.h"
+#include "reload.h"
+#include "schedule_jitter.h"
+#include "task_pool.h"
+#include "timer_wheel.h"
+#include "trigger_scheduler.h"
+
+// Address changes tend to arrive in bursts (DHCP renew, PPP reconnect):
+// wait for them to settle before running the early cycle.
+#define NETLINK_SETTLE_MS 2000
+#define NETLINK_BUFFER_SIZE 8192
+
+// Minimum spacing between cycles, and how long a burst of triggers may keep
+// pushing its cycle back.
+#define TRIGGER_DEBOUNCE_MS 1000
+#define TRIGGER_MAX_DELAY_MS 10000
+
+#define TIMER_WHEEL_TICK_MS 10
+
+struct daemon {
+  const DaemonOptions *options;
+  EventLoop loop;
+  EventSource timer;  // drives `timers`, armed at its next expiry
+  TimerWheel timers;
+  uint64_t timer_armed_ns;
+  WheelTimer interval;
+  uint64_t interval_due_ns;
+  WheelTimer kick;            // when the next coalesced cycle is due
+  WheelTimer drain_deadline;
+  EventSource signals;
+  EventSource netlink;
+  MetricsServer metrics;
+  EventSource pool_done;
+  TaskPool *pool;
+  ControlServer control;
+  DomainTable domains;
+  OutcomeTable outcomes;  // last cycle, one row per domain
+  DetectionGroup group;
+  IpSnapshot snapshot;
+  StateFile state;
+  char snapshot_path[MAX_STRING_LENGTH];
+  char metrics_address[MAX_STRING_LENGTH];
+  TriggerScheduler triggers;
+  CycleBudget *budget;
+  unsigned int cycle;
+  uint64_t last_cycle_end_ns;
+  ErrorFlags last_cycle_errors;
+  unsigned int interval_minutes;
+  bool draining;
+  InflightOp *inflight;
+  size_t inflight_count;
+};
+
+typedef struct daemon Daemon;
+
+// daemon_run() is not reentrant: one daemon per process, touched only from
+// the loop thread.
+static Daemon *active = NULL;
+
+// Keeps the timerfd on the wheel's next expiry; skips the syscall when it
+// has not moved.
+static void sync_timer(Daemon *d) {
+  uint64_t next_ns = timer_wheel_next_ns(&d->timers);
+  if (next_ns == d->timer_armed_ns) return;
+
+  struct itimerspec spec = {
+      .it_value = { .tv_sec = (time_t) (next_ns / NS_PER_SEC), .tv_nsec = (long) (next_ns % NS_PER_SEC) },
+  };
+
+  timerfd_settime(d->timer.fd, TFD_TIMER_ABSTIME, &spec, NULL);
+  d->timer_armed_ns = next_ns;
+}
+
+static void start_timer(Daemon *d, WheelTimer *timer, uint64_t deadline_ns) {
+  timer_wheel_schedule(&d->timers, timer, deadline_ns);
+  sync_timer(d);
+}
+
+static void stop_timer(Daemon *d, WheelTimer *timer) {
+  timer_wheel_cancel(&d->timers, timer);
+  sync_timer(d);
+}
+
+// Interval cycles land on wall-clock slots offset by this host's phase, so
+// a fleet with the same interval is spread over it instead of waking
+// together. The next slot is at least half an interval away, so a timer
+// firing a little early or late never yields a second cycle.
+static void arm_interval(Daemon *d) {
+  uint64_t interval_ns = (uint64_t) d->interval_minutes * 60 * NS_PER_SEC;
+  uint64_t now_ns = realtime_ns();
+  uint64_t next_ns = jitter_next_slot_ns(now_ns + interval_ns / 2, interval_ns);
+
+  d->interval_due_ns = monotonic_ns() + (next_ns - now_ns);
+  start_timer(d, &d->interval, d->interval_due_ns);
+}
+
+// Settings that outlive a single cycle are re-applied after every reload.
+// CONTROL_SOCKET is not: a reload may arrive through that very socket.
+static void apply_settings(Daemon *d, LiveConfig *cfg) {
+  MetaArray providers = env_ip_v4_apis(&cfg->env);
+  metrics_set_providers(providers.data, providers.length);
+
+  const char *group_dir = env_detection_group_dir(&cfg->env);
+
+  // Also retried when the same directory failed to open last time.
+  if (strcmp(group_dir, d->group.dir) != 0 || (*group_dir && !group_joined(&d->group))) group_open(&d->group, group_dir);
+
+  const char *snapshot_path = env_ip_snapshot_path(&cfg->env);
+
+  if (strcmp(snapshot_path, d->snapshot_path) != 0 || (*snapshot_path && !d->snapshot.data)) {
+    ip_snapshot_close(&d->snapshot);
+    snprintf(d->snapshot_path, sizeof(d->snapshot_path), "%s", snapshot_path);
+
+    if (*snapshot_path && !ip_snapshot_open_writer(&d->snapshot, snapshot_path)) {
+      LOG(LOG_MSG_SNAPSHOT_OPEN_FAILED, snapshot_path);
+    }
+  }
+
+  const char *metrics_address = env_metrics_listen(&cfg->env);
+
+  if (strcmp(metrics_address, d->metrics_address) != 0) {
+    metrics_server_close(&d->metrics);
+    snprintf(d->metrics_address, sizeof(d->metrics_address), "%s", metrics_address);
+
+    if (*metrics_address && !metrics_server_open(&d->metrics, &d->loop, metrics_address)) {
+      LOG(LOG_MSG_METRICS_LISTEN_FAILED, metrics_address);
+    }
+  }
+
+  unsigned int minutes = env_minutes_between_updates(&cfg->env);
+
+  if (minutes != d->interval_minutes) {
+    d->interval_minutes = minutes;
+    arm_interval(d);
+  }
+}
+
+static void arm_kick(Daemon *d, uint64_t due_ns) {
+  if (due_ns) start_timer(d, &d->kick, due_ns);
+}
+
+// Every reason to run a cycle goes through the scheduler, so bursts from
+// different sources end up in the same cycle.
+static void schedule(Daemon *d, trigger_source_t source, uint64_t delay_ns) {
+  if (d->draining) return;
+
+  arm_kick(d, trigger_request(&d->triggers, source, delay_ns, monotonic_ns()));
+}
+
+static void close_source(Daemon *d, EventSource *source) {
+  if (source->fd < 0) return;
+
+  event_loop_remove(&d->loop, source);
+  close(source->fd);
+  source->fd = -1;
+}
+
+void daemon_inflight_begin(InflightOp *op) {
+  Daemon *d = active;
+  if (!d) return;
+
+  op->prev = NULL;
+  op->next = d->inflight;
+  if (d->inflight) d->inflight->prev = op;
+
+  d->inflight = op;
+  d->inflight_count++;
+}
+
+void daemon_inflight_end(InflightOp *op) {
+  Daemon *d = active;
+  if (!d) return;
+
+  if (op->prev) {
+    op->prev->next = op->next;
+  } else {
+    d->inflight = op->next;
+  }
+
+  if (op->next) op->next->prev = op->prev;
+
+  op->prev = op->next = NULL;
+  d->inflight_count--;
+
+  if (d->draining && d->inflight_count == 0) event_loop_stop(&d->loop);
+}
+
+// Stop scheduling, then let in-flight work finish: the only timer left
+// is the drain deadline.
+static void begin_drain(Daemon *d) {
+  if (d->draining) {
+    LOG(LOG_MSG_SHUTDOWN_FORCED, NULL);
+    event_loop_stop(&d->loop);
+    return;
+  }
+
+  d->draining = true;
+  stop_timer(d, &d->interval);
+  stop_timer(d, &d->kick);
+  close_source(d, &d->netlink);
+
+  if (d->inflight_count == 0) {
+    event_loop_stop(&d->loop);
+    return;
+  }
+
+  LOG(LOG_MSG_SHUTDOWN_DRAINING, NULL, SHUTDOWN_DRAIN_SECONDS, d->inflight_count);
+
+  start_timer(d, &d->drain_deadline, monotonic_ns() + SHUTDOWN_DRAIN_SECONDS * NS_PER_SEC);
+}
+
+static void abort_inflight(Daemon *d) {
+  LOG(LOG_MSG_SHUTDOWN_ABORTED, NULL, d->inflight_count);
+
+  // abort() unlinks the op through daemon_inflight_end().
+  while (d->inflight) {
+    InflightOp *op = d->inflight;
+    op->abort(op);
+    if (d->inflight == op) daemon_inflight_end(op);
+  }
+
+  event_loop_stop(&d->loop);
+}
+
+// Acts on whatever the signalfd delivered, possibly read mid-cycle by
+// daemon_stop_requested().
+static void after_reload(Daemon *d, const DomainDelta *delta) {
+  LiveConfig *cfg = live_config_acquire();
+  apply_settings(d, cfg);
+  live_config_release(cfg);
+
+  // New domains should not wait for the next interval.
+  if (delta->added) schedule(d, TRIGGER_RELOAD, 0);
+}
+
+static void handle_signals(Daemon *d) {
+  if (signals_termination_requested()) {
+    if (!d->draining) begin_drain(d);
+    return;
+  }
+
+  DomainDelta delta;
+  if (daemon_reload_if_requested(d->options->env_file, &d->domains, &delta)) after_reload(d, &delta);
+}
+
+bool daemon_stop_requested(void) {
+  Daemon *d = active;
+  if (!d) return signals_termination_requested();
+
+  if (d->signals.fd >= 0) signals_read_fd(d->signals.fd);
+
+  return d->draining || signals_termination_requested();
+}
+
+// Domains whose state is fresh start warm: no zone or record lookups, and
+// no update while the IP stays the same.
+static void restore_state(Daemon *d, LiveConfig *cfg) {
+  if (!state_file_fresh(&d->state, env_state_max_age_minutes(&cfg->env) * 60)) return;
+
+  size_t restored = 0;
+
+  for (size_t i = 0; i < d->domains.length; i++) {
+    const StateFileRecord *record = state_file_find(&d->state, d->domains.items[i].name);
+    if (!record || !*record->record_id || !*record->content) continue;
+
+    if (domain_state_restore(&d->domains.items[i], record->zone_id, record->record_id, record->content)) restored++;
+  }
+
+  LOG(LOG_MSG_STATE_RESTORED, NULL, restored, d->domains.length);
+}
+
+// Every domain is written, known or not, so a flushed cache is not restored
+// on the next start either.
+static void save_state(Daemon *d, bool success) {
+  if (!d->state.header) return;
+
+  char *names[STATE_FILE_CAPACITY];
+  size_t count = MIN(d->domains.length, (size_t) STATE_FILE_CAPACITY);
+
+  state_file_begin(&d->state);
+
+  for (size_t i = 0; i < count; i++) {
+    const DomainState *s = &d->domains.items[i];
+
+    names[i] = s->name;
+    state_file_set_record(&d->state, s->name, s->zone_id, s->record_id, s->last_ip);
+  }
+
+  state_file_retain(&d->state, names, count);
+  state_file_commit(&d->state, success);
+}
+
+static void run_cycle(Daemon *d, unsigned int sources, unsigned int merged) {
+  LiveConfig *cfg = live_config_acquire();
+  if (!cfg) return;
+
+  if (log_enabled(LOG_MSG_CYCLE_TRIGGERED)) {
+    char names[LOG_INLINE_STRING_SIZE] = "";
+
+    for (size_t i = 0; i < TRIGGER_SOURCE_COUNT; i++) {
+      if (!(sources & (1u << i))) continue;
+
+      size_t len = strlen(names);
+      snprintf(names + len, sizeof(names) - len, "%s%s", len ? "+" : "", trigger_source_name(i));
+    }
+
+    LOG(LOG_MSG_CYCLE_TRIGGERED, names, d->cycle + 1, merged);
+  }
+
+  // Only the group leader (or an instance detecting alone) queries the IP
+  // providers. A follower takes over here once the leader's lock is
+  // released, and detects on its own while the leader's IP is stale.
+  char shared_ipv4[INET_ADDRSTRLEN];
+  bool follower = group_joined(&d->group) && !group_try_lead(&d->group) &&
+                  group_read(&d->group, shared_ipv4, sizeof(shared_ipv4), 2 * d->interval_minutes * 60);
+
+  ErrorContext ctx;
+  error_scope_begin(&ctx);
+
+  // Sized again only when a reload changed the domain count.
+  if (d->outcomes.length == d->domains.length) {
+    outcome_table_reset(&d->outcomes);
+  } else {
+    outcome_table_free(&d->outcomes);
+    outcome_table_init(&d->outcomes, d->domains.length);
+  }
+
+  cycle_budget_begin(d->budget, ++d->cycle, env_cycle_budget_seconds(&cfg->env));
+  bool ok = !d->options->cycle || d->options->cycle(cfg, &d->domains, &d->outcomes, d->budget,
+                                                    follower ? shared_ipv4 : NULL, d->options->ctx);
+  cycle_budget_end(d->budget, stderr);
+
+  ErrorFlags flags = error_scope_end(&ctx);
+
+  if (outcome_count(&d->outcomes, OUTCOME_SET_FAILED)) ok = false;
+
+  d->last_cycle_end_ns = monotonic_ns();
+  d->last_cycle_errors = flags;
+
+  // Without an update step nothing was pushed, so there is no success to
+  // record: state_file_fresh() would otherwise skip the next real update.
+  save_state(d, d->options->cycle && ok && !flags);
+
+  LOG(ok && !flags ? LOG_MSG_CYCLE_DONE : LOG_MSG_CYCLE_FAILED, NULL, d->cycle,
+      d->budget->duration_ns / NS_PER_MS, flags);
+
+  live_config_release(cfg);
+
+  // Signals picked up by daemon_stop_requested() during the cycle.
+  handle_signals(d);
+}
+
+static void on_timer(EventSource *source, uint32_t events) {
+  (void) events;
+  Daemon *d = source->ctx;
+  uint64_t expirations;
+
+  if (read(source->fd, &expirations, sizeof(expirations)) != sizeof(expirations)) return;
+
+  d->timer_armed_ns = 0;  // a fired absolute timer stays disarmed
+  timer_wheel_advance(&d->timers, monotonic_ns());
+  sync_timer(d);
+}
+
+// Re-derived from the wall clock every time, so slow cycles, suspend and
+// clock steps don't make the schedule drift off its slot.
+static void on_interval(WheelTimer *timer) {
+  Daemon *d = timer->ctx;
+
+  arm_interval(d);
+  schedule(d, TRIGGER_INTERVAL, 0);
+}
+
+static void on_kick(WheelTimer *timer) {
+  Daemon *d = timer->ctx;
+  unsigned int sources, merged;
+
+  if (d->draining || !trigger_begin_cycle(&d->triggers, monotonic_ns(), &sources, &merged)) return;
+
+  run_cycle(d, sources, merged);
+
+  if (!d->draining) arm_kick(d, trigger_end_cycle(&d->triggers, monotonic_ns()));
+}
+
+static void on_drain_deadline(WheelTimer *timer) { abort_inflight(timer->ctx); }
+
+static void on_pool_done(EventSource *source, uint32_t events) {
+  (void) events;
+  Daemon *d = source->ctx;
+  task_pool_complete(d->pool);
+}
+
+void daemon_task_submit(PoolTask *task) {
+  Daemon *d = active;
+
+  if (d && d->pool) {
+    task_pool_submit(d->pool, task);
+    return;
+  }
+
+  task->run(task);
+  if (task->done) task->done(task);
+}
+
+void daemon_publish_ip(const char *ipv4, const char *ipv6) {
+  Daemon *d = active;
+  if (!d) return;
+
+  ip_snapshot_publish(&d->snapshot, ipv4, ipv6);
+
+  if (ipv4 && *ipv4) {
+    group_publish(&d->group, ipv4);
+
+    // Committed with the records at the end of the cycle.
+    state_file_begin(&d->state);
+    state_file_set_detected(&d->state, ipv4);
+  }
+}
+
+void daemon_timer_schedule(WheelTimer *timer, uint64_t delay_ns) {
+  Daemon *d = active;
+  if (d) start_timer(d, timer, monotonic_ns() + delay_ns);
+}
+
+void daemon_timer_cancel(WheelTimer *timer) {
+  Daemon *d = active;
+  if (d) stop_timer(d, timer);
+}
+
+static void on_signal(EventSource *source, uint32_t events) {
+  (void) events;
+  Daemon *d = source->ctx;
+
+  // A further termination signal while draining forces the stop.
+  unsigned int terminations = signals_termination_count();
+
+  signals_read_fd(source->fd);
+
+  if (d->draining && signals_termination_count() != terminations) {
+    begin_drain(d);
+    return;
+  }
+
+  handle_signals(d);
+}
+
+static void on_netlink(EventSource *source, uint32_t events) {
+  (void) events;
+  Daemon *d = source->ctx;
+  char buffer[NETLINK_BUFFER_SIZE];
+  bool changed = false;
+  ssize_t n;
+
+  while ((n = recv(source->fd, buffer, sizeof(buffer), 0)) > 0) {
+    for (struct nlmsghdr *h = (struct nlmsghdr *) buffer; NLMSG_OK(h, (size_t) n); h = NLMSG_NEXT(h, n)) {
+      if (h->nlmsg_type == RTM_NEWADDR || h->nlmsg_type == RTM_DELADDR) changed = true;
+    }
+  }
+
+  // An ISP-wide renumbering reaches the whole fleet at once.
+  if (changed) {
+    schedule(d, TRIGGER_NETLINK, NETLINK_SETTLE_MS * NS_PER_MS + jitter_ns(JITTER_NETLINK, NETLINK_SPREAD_SECONDS * NS_PER_SEC));
+  }
+}
+
+static bool control_trigger_now(void *ctx, FILE *reply) {
+  (void) reply;
+  Daemon *d = ctx;
+
+  if (d->draining) return false;
+
+  schedule(d, TRIGGER_CONTROL, 0);
+
+  return true;
+}
+
+static bool control_status(void *ctx, FILE *reply) {
+  Daemon *d = ctx;
+  uint64_t now_ns = monotonic_ns();
+  LiveConfig *cfg = live_config_acquire();
+
+  fprintf(reply, "cycles %u\n", d->cycle);
+  fprintf(reply, "state %s\n", d->draining ? "draining" : "running");
+  fprintf(reply, "config_generation %llu\n", cfg ? (unsigned long long) cfg->generation : 0ull);
+  fprintf(reply, "interval_minutes %u\n", d->interval_minutes);
+  fprintf(reply, "interval_phase_s %llu\n",
+          (unsigned long long) (jitter_ns(JITTER_INTERVAL_PHASE, (uint64_t) d->interval_minutes * 60 * NS_PER_SEC) / NS_PER_SEC));
+  IpSnapshotValue published;
+  if (ip_snapshot_read(&d->snapshot, &published)) fprintf(reply, "snapshot_sequence %llu\n", (unsigned long long) published.sequence);
+
+  fprintf(reply, "role %s\n", !group_joined(&d->group) ? "standalone" : d->group.leader ? "leader" : "follower");
+  fprintf(reply, "next_cycle_in_s %llu\n",
+          (unsigned long long) (d->interval.pending && d->interval_due_ns > now_ns ? (d->interval_due_ns - now_ns) / NS_PER_SEC : 0));
+
+  if (d->cycle) {
+    fprintf(reply, "last_cycle_ms %.1f\n", (double) d->budget->duration_ns / NS_PER_MS);
+    fprintf(reply, "last_cycle_age_s %llu\n", (unsigned long long) ((now_ns - d->last_cycle_end_ns) / NS_PER_SEC));
+    fprintf(reply, "last_cycle_errors 0x%x\n", d->last_cycle_errors);
+
+    OutcomeSummary outcomes = outcome_summarize(&d->outcomes);
+    fprintf(reply, "last_cycle_changed %zu\n", outcomes.counts[OUTCOME_SET_CHANGED]);
+    fprintf(reply, "last_cycle_failed %zu\n", outcomes.counts[OUTCOME_SET_FAILED]);
+    fprintf(reply, "last_cycle_skipped %zu\n", outcomes.counts[OUTCOME_SET_SKIPPED]);
+  }
+
+  if (d->state.header && d->state.header->last_success_at) {
+    fprintf(reply, "state_last_success_at %llu\n", (unsigned long long) d->state.header->last_success_at);
+  }
+
+  fprintf(reply, "inflight %zu\n", d->inflight_count);
+  fprintf(reply, "triggers_pending %s\n", d->triggers.first_ns || d->triggers.follow_up ? "yes" : "no");
+  fprintf(reply, "triggers_coalesced %llu\n", (unsigned long long) d->triggers.coalesced);
+  fprintf(reply, "timers %zu\n", timer_wheel_count(&d->timers));
+
+  if (d->pool) {
+    TaskPoolStats pool;
+    task_pool_stats(d->pool, &pool);
+    fprintf(reply, "pool_workers %zu\npool_tasks %llu\npool_steals %llu\n", pool.workers,
+            (unsigned long long) pool.executed, (unsigned long long) pool.stolen);
+  }
+
+  for (size_t i = 0; i < d->domains.length; i++) {
+    const DomainState *s = &d->domains.items[i];
+
+    fprintf(reply, "domain %s ip=%s zone=%s record=%s queued=%s errors=0x%x\n", s->name,
+            s->last_ip[0] ? s->last_ip : "-", s->zone_id ? s->zone_id : "-", s->record_id ? s->record_id : "-",
+            s->queued ? "yes" : "no", s->errors);
+  }
+
+  live_config_release(cfg);
+
+  return true;
+}
+
+// Forgets every cached lookup, so the next cycle re-resolves zones and
+// records and re-checks each domain against the public IP.
+static bool control_flush_caches(void *ctx, FILE *reply) {
+  Daemon *d = ctx;
+
+  for (size_t i = 0; i < d->domains.length; i++) {
+    DomainState *s = &d->domains.items[i];
+
+    mm_free(s->zone_id);
+    mm_free(s->record_id);
+
+    s->zone_id = NULL;
+    s->record_id = NULL;
+    s->last_ip[0] = '\0';
+    s->queued = true;
+  }
+
+  fprintf(reply, "flushed %zu\n", d->domains.length);
+
+  return true;
+}
+
+static bool control_reload(void *ctx, FILE *reply) {
+  Daemon *d = ctx;
+
+  ErrorContext scope;
+  error_scope_begin(&scope);
+
+  DomainDelta delta = daemon_reload(d->options->env_file, &d->domains);
+
+  ErrorFlags flags = error_scope_end(&scope);
+
+  if (flags & ERR_RELOAD) {
+    LOG(LOG_MSG_RELOAD_FAILED, NULL, flags);
+    fprintf(reply, "errors 0x%x\n", flags);
+    return false;
+  }
+
+  LOG(LOG_MSG_RELOAD_APPLIED, NULL, delta.added, delta.removed, delta.kept);
+  fprintf(reply, "added %zu\nremoved %zu\nkept %zu\n", delta.added, delta.removed, delta.kept);
+
+  after_reload(d, &delta);
+
+  return true;
+}
+
+static int open_netlink(void) {
+  int fd = socket(AF_NETLINK, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_ROUTE);
+  if (fd < 0) return -1;
+
+  struct sockaddr_nl addr = { .nl_family = AF_NETLINK, .nl_groups = RTMGRP_IPV4_IFADDR };
+
+  if (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) != 0) {
+    close(fd);
+    return -1;
+  }
+
+  return fd;
+}
+
+static bool add_source(Daemon *d, EventSource *source, int fd, event_handler_fn handler) {
+  source->fd = fd;
+  source->handler = handler;
+  source->ctx = d;
+
+  return fd >= 0 && event_loop_add(&d->loop, source, EPOLLIN);
+}
+
+// Format checks only, so startup needs no network. An invalid setting would
+// otherwise run silently on its default until someone reads the logs.
+static bool check_settings(LiveConfig *cfg) {
+  ValidationReport report;
+  bool ok = validate_configuration(&cfg->env, NULL, &report);
+
+  if (!ok) report_print(&report, stderr);
+  report_free(&report);
+
+  return ok;
+}
+
+// Loads and publishes the first snapshot and builds the domain table.
+static LiveConfig *load_initial(Daemon *d) {
+  LiveConfig *cfg = live_config_load(d->options->env_file);
+  if (!cfg) return NULL;
+
+  MetaArray domains = env_domains(&cfg->env);
+  domain_table_apply(&d->domains, domains.data, domains.length);
+
+  if (error_has(ERR_ALLOC_FAILURE)) {
+    live_config_release(cfg);
+    return NULL;
+  }
+
+  live_config_publish(cfg);
+
+  return live_config_acquire();
+}
+
+int daemon_run(const DaemonOptions *options) {
+  Daemon d = { .options = options, .loop.epoll_fd = -1, .timer.fd = -1, .signals.fd = -1, .netlink.fd = -1, .metrics.listener.fd = -1, .pool_done.fd = -1, .group.lock_fd = -1,
+               .control.listener.fd = -1 };
+  char latency_path[MAX_STRING_LENGTH], state_file_path[MAX_STRING_LENGTH];
+  int status = EXIT_FAILURE;
+
+  // Before any thread exists, so every thread inherits the blocked mask.
+  int signal_fd = signals_open_fd();
+
+  LiveConfig *cfg = load_initial(&d);
+  d.budget = mm_calloc(1, sizeof(CycleBudget));
+
+  if (!cfg || !d.budget || signal_fd < 0 || !event_loop_init(&d.loop)) {
+    fprintf(stderr, "daemon: startup failed (errors 0x%x)\n", error_flags());
+    goto cleanup;
+  }
+
+  if (!check_settings(cfg)) {
+    fprintf(stderr, "daemon: invalid configuration, not starting\n");
+    goto cleanup;
+  }
+
+  log_init(STDERR_FILENO, env_log_level(&cfg->env));
+
+  if (add_source(&d, &d.signals, signal_fd, on_signal)) signal_fd = -1;  // owned by d.signals now
+
+  if (signal_fd >= 0 || !add_source(&d, &d.timer, timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC), on_timer)) {
+    fprintf(stderr, "daemon: cannot set up the event loop\n");
+    goto cleanup;
+  }
+
+  // Without a pool, daemon_task_submit() runs tasks inline.
+  d.pool = task_pool_create(0);
+
+  if (d.pool && !add_source(&d, &d.pool_done, task_pool_fd(d.pool), on_pool_done)) {
+    d.pool_done.fd = -1;  // owned by the pool
+    task_pool_destroy(d.pool);
+    d.pool = NULL;
+  }
+
+  // Both are optional: without netlink only the interval timer triggers.
+  if (!add_source(&d, &d.netlink, open_netlink(), on_netlink)) close_source(&d, &d.netlink);
+
+  const char *control_path = env_control_socket(&cfg->env);
+  ControlHandlers handlers = {
+      .trigger_now = control_trigger_now,
+      .status = control_status,
+      .flush_caches = control_flush_caches,
+      .reload = control_reload,
+      .ctx = &d,
+  };
+
+  if (*control_path && !control_server_open(&d.control, &d.loop, control_path, &handlers)) {
+    fprintf(stderr, "daemon: cannot open control socket %s\n", control_path);
+  }
+
+  timer_wheel_init(&d.timers, TIMER_WHEEL_TICK_MS * NS_PER_MS, monotonic_ns());
+  d.interval = (WheelTimer) { .callback = on_interval, .ctx = &d };
+  d.kick = (WheelTimer) { .callback = on_kick, .ctx = &d };
+  d.drain_deadline = (WheelTimer) { .callback = on_drain_deadline, .ctx = &d };
+
+  state_path(state_file_path, sizeof(state_file_path), UPDATE_STATE_FILE);
+
+  if (state_file_open(&d.state, state_file_path)) {
+    restore_state(&d, cfg);
+  } else {
+    LOG(LOG_MSG_STATE_OPEN_FAILED, state_file_path);
+  }
+
+  apply_settings(&d, cfg);
+  live_config_release(cfg);
+  cfg = NULL;
+
+  latency_store_path(latency_path, sizeof(latency_path));
+  latency_store_load(latency_path);
+
+  active = &d;
+
+  trigger_init(&d.triggers, TRIGGER_DEBOUNCE_MS * NS_PER_MS, TRIGGER_MAX_DELAY_MS * NS_PER_MS);
+  // Spread out fleet-wide restarts (power cuts, rollouts) too.
+  uint64_t startup_span_ns = MIN((uint64_t) STARTUP_SPREAD_SECONDS * NS_PER_SEC, (uint64_t) d.interval_minutes * 60 * NS_PER_SEC);
+  schedule(&d, TRIGGER_INTERVAL, jitter_ns(JITTER_STARTUP, startup_span_ns));
+
+  event_loop_run(&d.loop);
+
+  active = NULL;
+
+  latency_store_save(latency_path);
+  status = EXIT_SUCCESS;
+
+cleanup:
+  live_config_release(cfg);
+
+  // Finishes whatever is still queued; its done callbacks run here.
+  if (d.pool_done.fd >= 0) event_loop_remove(&d.loop, &d.pool_done);
+  task_pool_destroy(d.pool);
+
+  control_server_close(&d.control);
+  metrics_server_close(&d.metrics);
+  close_source(&d, &d.netlink);
+  close_source(&d, &d.timer);
+  close_source(&d, &d.signals);
+  signals_close_fd(signal_fd);
+  event_loop_free(&d.loop);
+  group_close(&d.group);
+  ip_snapshot_close(&d.snapshot);
+  state_file_close(&d.state);
+  domain_table_free(&d.domains);
+  outcome_table_free(&d.outcomes);
+  mm_free(d.budget);
+  log_shutdown();
+
+  return status;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "../common.h"
+#include "cycle_budget.h"
+#include "detection_group.h"
+#include "domain_table.h"
+#include "live_config.h"
+#include "outcome_table.h"
+#include "task_pool.h"
+#include "timer_wheel.h"
+
+// One update cycle against a pinned snapshot. Runs on the loop thread inside
+// its own error scope; returns false if the cycle failed. `outcomes` has one
+// row per entry of `domains`, reset before every cycle; the cycle records
+// what happened to each domain there.
+//
+// `group_ipv4` is set when this instance follows a DETECTION_GROUP_DIR
+// leader whose published IPv4 address is recent enough: the cycle must use
+// it instead of querying the IP providers for IPv4. NULL means detect.
+typedef bool (*daemon_cycle_fn)(LiveConfig *cfg, DomainTable *domains, OutcomeTable *outcomes, CycleBudget *budget,
+                                const char *group_ipv4, void *ctx);
+
+struct daemon_options {
+  const char *env_file;  // NULL = process environment only
+  daemon_cycle_fn cycle;
+  void *ctx;
+};
+
+typedef struct daemon_options DaemonOptions;
+
+// Work that may still be running when a cycle returns (requests driven by the
+// event loop). Registered operations are waited for on shutdown; those still
+// pending at the drain deadline get `abort` called, which must cancel the
+// operation and call daemon_inflight_end(). Loop thread only.
+struct inflight_op {
+  void (*abort)(struct inflight_op *op);
+  struct inflight_op *prev;
+  struct inflight_op *next;
+};
+
+typedef struct inflight_op InflightOp;
+
+void daemon_inflight_begin(InflightOp *op);
+
+void daemon_inflight_end(InflightOp *op);
+
+// Runs CPU-heavy work (parsing, diffing, payload building) on the daemon's
+// worker pool; `done` comes back on the loop thread. Tasks still queued at
+// shutdown run to completion before daemon_run() returns. Outside
+// daemon_run(), or without a pool, the task runs inline.
+void daemon_task_submit(PoolTask *task);
+
+// Publishes a freshly detected public IP (either may be NULL) to the
+// IP_SNAPSHOT_PATH snapshot and, when leading, the IPv4 address to the
+// detection group.
+void daemon_publish_ip(const char *ipv4, const char *ipv6);
+
+// One-shot timers on the daemon's timer wheel (see timer_wheel.h), for
+// per-domain schedules, retries and probes. All share the daemon's single
+// timerfd. Callbacks run on the loop thread. No-ops outside daemon_run().
+void daemon_timer_schedule(WheelTimer *timer, uint64_t delay_ns);
+
+void daemon_timer_cancel(WheelTimer *timer);
+
+// For long cycles: checks for a pending termination signal without waiting
+// for the cycle to return. A cycle should stop starting new updates once
+// this is true, and finish (not abandon) the ones already sent.
+bool daemon_stop_requested(void);
+
+// Runs the update loop until SIGINT/SIGTERM/SIGQUIT. A single epoll loop
+// waits on one timerfd driving the timer wheel, a signalfd (SIGHUP reloads the config), a
+// netlink socket (an address change triggers an early cycle) and, when set,
+// the METRICS_LISTEN listener and the CONTROL_SOCKET (see control.h).
+//
+// Termination is graceful: scheduling stops, in-flight operations get up to
+// SHUTDOWN_DRAIN_SECONDS to finish (then are aborted), and state and logs
+// are flushed before returning. A second signal skips the drain. Returns an
+// exit code.
+int daemon_run(const DaemonOptions *options);
@@ -0,0 +1,111 @@
+#include "detection_group.h"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../logging/log.h"
+
+#define PUBLISHED_MAX_SIZE 64  // "255.255.255.255 <unix time>\n"
+
+static bool group_path(const DetectionGroup *group, const char *name, char *out, size_t size) {
+  return snprintf(out, size, "%s/%s", group->dir, name) < (int) size;
+}
+
+void group_init(DetectionGroup *group) { *group = (DetectionGroup) { .lock_fd = -1 }; }
+
+bool group_open(DetectionGroup *group, const char *dir) {
+  group_close(group);
+
+  if (!*dir) return true;
+
+  char path[MAX_STRING_LENGTH];
+
+  snprintf(group->dir, sizeof(group->dir), "%s", dir);
+  if (group_path(group, DETECTION_GROUP_LOCK_FILE, path, sizeof(path))) {
+    group->lock_fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0660);
+  }
+
+  if (group->lock_fd < 0) {
+    LOG(LOG_MSG_GROUP_OPEN_FAILED, dir);
+    return false;
+  }
+
+  return true;
+}
+
+void group_close(DetectionGroup *group) {
+  // Closing the descriptor releases the lock for the next instance.
+  if (group->lock_fd >= 0) close(group->lock_fd);
+
+  group->lock_fd = -1;
+  group->leader = false;
+}
+
+bool group_try_lead(DetectionGroup *group) {
+  if (group->lock_fd < 0 || group->leader) return group->leader;
+
+  if (flock(group->lock_fd, LOCK_EX | LOCK_NB) == 0) {
+    group->leader = true;
+    LOG(LOG_MSG_GROUP_LEADER, group->dir);
+  }
+
+  return group->leader;
+}
+
+bool group_publish(DetectionGroup *group, const char *ip) {
+  if (!group->leader) return false;
+
+  char path[MAX_STRING_LENGTH], tmp[MAX_STRING_LENGTH];
+
+  if (!group_path(group, DETECTION_GROUP_IP_FILE, path, sizeof(path))) return false;
+  if (snprintf(tmp, sizeof(tmp), "%s.tmp.%u", path, (unsigned int) getpid()) >= (int) sizeof(tmp)) return false;
+
+  FILE *file = fopen(tmp, "w");
+  if (!file) return false;
+
+  // Wall-clock time: the instances may not share a monotonic clock
+  // (separate time namespaces).
+  bool ok = fprintf(file, "%s %lld\n", ip, (long long) time(NULL)) > 0;
+  ok = fclose(file) == 0 && ok;
+
+  if (!ok || rename(tmp, path) != 0) {
+    unlink(tmp);
+    return false;
+  }
+
+  return true;
+}
+
+bool group_read(const DetectionGroup *group, char *ip, size_t size, unsigned int max_age_s) {
+  if (group->lock_fd < 0) return false;
+
+  char path[MAX_STRING_LENGTH], line[PUBLISHED_MAX_SIZE], address[INET_ADDRSTRLEN];
+  long long published;
+  struct in_addr parsed;
+
+  if (!group_path(group, DETECTION_GROUP_IP_FILE, path, sizeof(path))) return false;
+
+  FILE *file = fopen(path, "r");
+  if (!file) return false;
+
+  bool ok = fgets(line, sizeof(line), file) && sscanf(line, "%15s %lld", address, &published) == 2 &&
+            inet_pton(AF_INET, address, &parsed) == 1;
+
+  fclose(file);
+
+  if (!ok) return false;
+
+  long long age = (long long) time(NULL) - published;
+
+  if (age > (long long) max_age_s) {
+    LOG(LOG_MSG_GROUP_STALE, address, (uint64_t) age);
+    return false;
+  }
+
+  snprintf(ip, size, "%s", address);
+
+  return true;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "../common.h"
+
+// Leader election between instances sharing a directory. The leader holds
+// an exclusive flock() on DETECTION_GROUP_LOCK_FILE for as long as it runs
+// (the kernel drops it when the process dies, so there is no lease to
+// renew). Only the leader queries the IP providers; it publishes the result
+// in DETECTION_GROUP_IP_FILE (written to a temporary file, then renamed)
+// and followers read that instead. Followers retry the lock every cycle.
+// Only the IPv4 address is shared: IPv6 addresses usually differ per host,
+// so every instance detects its own.
+struct detection_group {
+  int lock_fd;  // -1 = not in a group
+  bool leader;
+  char dir[MAX_STRING_LENGTH];
+};
+
+typedef struct detection_group DetectionGroup;
+
+void group_init(DetectionGroup *group);
+
+// Joins the group in `dir` (which must exist), leaving any previous one.
+// "" leaves without joining. Returns false if the lock file can't be opened.
+bool group_open(DetectionGroup *group, const char *dir);
+
+void group_close(DetectionGroup *group);
+
+static inline bool group_joined(const DetectionGroup *group) { return group->lock_fd >= 0; }
+
+// Takes the lock if it is free. True while this instance is the leader.
+bool group_try_lead(DetectionGroup *group);
+
+// Leader only: publishes the detected IPv4 address.
+bool group_publish(DetectionGroup *group, const char *ip);
+
+// Follower: the leader's last published IPv4 address, if no older than
+// `max_age_s`.
+// False when missing, unreadable or stale; the caller should then detect
+// on its own.
+bool group_read(const DetectionGroup *group, char *ip, size_t size, unsigned int max_age_s);
@@ -0,0 +1,119 @@
+#include "domain_table.h"
+
+static char *copy_string(const char *src) {
+  size_t len = strlen(src);
+
+  char *dst = mm_malloc(len + 1);
+  if (error_has(ERR_ALLOC_FAILURE)) return NULL;
+
+  memcpy(dst, src, len + 1);
+
+  return dst;
+}
+
+static void free_state(DomainState *state) {
+  mm_free(state->name);
+  mm_free(state->zone_id);
+  mm_free(state->record_id);
+}
+
+static bool init_state(DomainState *state, const char *name) {
+  *state = (DomainState) {
+      .name = copy_string(name),
+      .zone_id = NULL,
+      .record_id = NULL,
+      .last_ip = "",
+      .queued = true,
+      .errors = ERR_NONE,
+  };
+
+  return state->name != NULL;
+}
+
+bool domain_state_restore(DomainState *state, const char *zone_id, const char *record_id, const char *last_ip) {
+  char *zone = copy_string(zone_id);
+  char *record = copy_string(record_id);
+
+  if (!zone || !record) {
+    mm_free(zone);
+    mm_free(record);
+    return false;
+  }
+
+  mm_free(state->zone_id);
+  mm_free(state->record_id);
+
+  state->zone_id = zone;
+  state->record_id = record;
+  snprintf(state->last_ip, sizeof(state->last_ip), "%s", last_ip);
+  state->queued = false;
+
+  return true;
+}
+
+static int compare_state_name(const void *key, const void *item) {
+  return strcmp((const char *) key, ((const DomainState *) item)->name);
+}
+
+DomainState *domain_table_find(const DomainTable *table, const char *name) {
+  if (!table || !name || table->length == 0) return NULL;
+
+  return bsearch(name, table->items, table->length, sizeof(DomainState), compare_state_name);
+}
+
+DomainDelta domain_table_apply(DomainTable *table, char *const *sorted_names, size_t count) {
+  DomainDelta delta = { .added = 0, .removed = 0, .kept = 0 };
+
+  DomainState *items = count ? mm_calloc(count, sizeof(DomainState)) : NULL;
+  if (error_has(ERR_ALLOC_FAILURE)) return delta;
+
+  // Allocate every new entry up front so a failure leaves the table untouched.
+  for (size_t i = 0; i < count; i++) {
+    if (domain_table_find(table, sorted_names[i])) continue;
+
+    if (!init_state(&items[i], sorted_names[i])) {
+      for (size_t j = 0; j < i; j++) free_state(&items[j]);
+      mm_free(items);
+      return (DomainDelta) { .added = 0, .removed = 0, .kept = 0 };
+    }
+
+    delta.added++;
+  }
+
+  // Both sides are sorted: one merge pass moves the warm states across.
+  size_t old_idx = 0;
+
+  for (size_t i = 0; i < count && old_idx < table->length; i++) {
+    if (items[i].name) continue;
+
+    while (strcmp(table->items[old_idx].name, sorted_names[i]) < 0) old_idx++;
+
+    items[i] = table->items[old_idx];
+    table->items[old_idx].name = NULL;
+    old_idx++;
+    delta.kept++;
+  }
+
+  for (size_t i = 0; i < table->length; i++) {
+    if (table->items[i].name == NULL) continue;
+
+    free_state(&table->items[i]);
+    delta.removed++;
+  }
+
+  mm_free(table->items);
+  table->items = items;
+  table->length = count;
+
+  return delta;
+}
+
+void domain_table_free(DomainTable *table) {
+  if (!table) return;
+
+  for (size_t i = 0; i < table->length; i++) free_state(&table->items[i]);
+
+  mm_free(table->items);
+  table->items = NULL;
+  table->length = 0;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "../common.h"
+#include "../errors/errors.h"
+#include "../memory/memory_management.h"
+
+// Per-domain warm state kept across update cycles (and across reloads for
+// domains that are still configured).
+struct domain_state {
+  char *name;
+  char *zone_id;
+  char *record_id;
+  char last_ip[IPV4_STRING_SIZE];
+  bool queued;
+  ErrorFlags errors;  // flags from this domain's last update (its own scope)
+};
+
+typedef struct domain_state DomainState;
+
+// Sorted by name so a reload can be merged against a sorted domain list.
+struct domain_table {
+  DomainState *items;
+  size_t length;
+};
+
+typedef struct domain_table DomainTable;
+
+struct domain_delta {
+  size_t added;
+  size_t removed;
+  size_t kept;
+};
+
+typedef struct domain_delta DomainDelta;
+
+// Rebuilds `table` so it holds exactly `sorted_names`: unchanged domains keep
+// their state, new ones are created queued and removed ones are freed. On
+// allocation failure the table is left untouched.
+DomainDelta domain_table_apply(DomainTable *table, char *const *sorted_names, size_t count);
+
+// Warms a domain from persisted state: cached ids and the IP last pushed,
+// no longer queued. False (state unchanged) on allocation failure.
+bool domain_state_restore(DomainState *state, const char *zone_id, const char *record_id, const char *last_ip);
+
+DomainState *domain_table_find(const DomainTable *table, const char *name);
+
+void domain_table_free(DomainTable *table);
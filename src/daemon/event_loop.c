@@ -0,0 +1,74 @@
+#include "event_loop.h"
+
+#include <errno.h>
+#include <unistd.h>
+
+#define EVENT_BATCH 16
+
+bool event_loop_init(EventLoop *loop) {
+  loop->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  loop->running = false;
+  loop->batch = NULL;
+  loop->batch_length = 0;
+
+  return loop->epoll_fd >= 0;
+}
+
+static bool control(EventLoop *loop, int op, EventSource *source, uint32_t events) {
+  struct epoll_event ev = { .events = events, .data.ptr = source };
+
+  return epoll_ctl(loop->epoll_fd, op, source->fd, &ev) == 0;
+}
+
+bool event_loop_add(EventLoop *loop, EventSource *source, uint32_t events) {
+  return control(loop, EPOLL_CTL_ADD, source, events);
+}
+
+bool event_loop_modify(EventLoop *loop, EventSource *source, uint32_t events) {
+  return control(loop, EPOLL_CTL_MOD, source, events);
+}
+
+void event_loop_remove(EventLoop *loop, EventSource *source) {
+  if (source->fd >= 0) epoll_ctl(loop->epoll_fd, EPOLL_CTL_DEL, source->fd, NULL);
+
+  for (int i = 0; i < loop->batch_length; i++) {
+    if (loop->batch[i].data.ptr == source) loop->batch[i].data.ptr = NULL;
+  }
+}
+
+void event_loop_run(EventLoop *loop) {
+  struct epoll_event events[EVENT_BATCH];
+
+  loop->running = true;
+
+  while (loop->running) {
+    int n = epoll_wait(loop->epoll_fd, events, EVENT_BATCH, -1);
+
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      break;
+    }
+
+    loop->batch = events;
+    loop->batch_length = n;
+
+    for (int i = 0; i < n && loop->running; i++) {
+      EventSource *source = events[i].data.ptr;
+      if (source) source->handler(source, events[i].events);
+    }
+
+    loop->batch = NULL;
+    loop->batch_length = 0;
+  }
+
+  loop->running = false;
+}
+
+void event_loop_stop(EventLoop *loop) {
+  loop->running = false;
+}
+
+void event_loop_free(EventLoop *loop) {
+  if (loop->epoll_fd >= 0) close(loop->epoll_fd);
+  loop->epoll_fd = -1;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <sys/epoll.h>
+
+#include "../common.h"
+
+struct event_source;
+
+typedef void (*event_handler_fn)(struct event_source *source, uint32_t events);
+
+// Anything the loop waits on: timers, signals, netlink, sockets. The source
+// itself is the epoll cookie, so it must not move while registered; handlers
+// reach their owner through `ctx`.
+struct event_source {
+  int fd;
+  event_handler_fn handler;
+  void *ctx;
+};
+
+typedef struct event_source EventSource;
+
+struct event_loop {
+  int epoll_fd;
+  bool running;
+  struct epoll_event *batch;  // being dispatched, NULL between batches
+  int batch_length;
+};
+
+typedef struct event_loop EventLoop;
+
+bool event_loop_init(EventLoop *loop);
+
+bool event_loop_add(EventLoop *loop, EventSource *source, uint32_t events);
+
+bool event_loop_modify(EventLoop *loop, EventSource *source, uint32_t events);
+
+// Also drops events already fetched for `source` in the batch being
+// dispatched, so a handler may remove and free any source, not only its own.
+void event_loop_remove(EventLoop *loop, EventSource *source);
+
+// Blocks in epoll_wait() until a source is ready; there is no periodic tick.
+// Returns after event_loop_stop() is called from a handler.
+void event_loop_run(EventLoop *loop);
+
+void event_loop_stop(EventLoop *loop);
+
+void event_loop_free(EventLoop *loop);
@@ -0,0 +1,151 @@
+#include "ip_snapshot.h"
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../utils/time_utils.h"
+
+#define HEADER ((uint64_t) IP_SNAPSHOT_MAGIC << 32 | IP_SNAPSHOT_VERSION)
+#define IPV4_PRESENT (1ull << 32)
+
+static bool map(IpSnapshot *snapshot, const char *path, bool writable) {
+  int fd = open(path, writable ? O_RDWR | O_CREAT | O_CLOEXEC : O_RDONLY | O_CLOEXEC, 0644);
+  if (fd < 0) return false;
+
+  // Taken before anything is written, so a second writer never touches the
+  // live file.
+  if (writable && flock(fd, LOCK_EX | LOCK_NB) != 0) {
+    close(fd);
+    return false;
+  }
+
+  struct stat st;
+
+  bool ok = fstat(fd, &st) == 0 &&
+            (st.st_size >= (off_t) sizeof(struct ip_snapshot_data) ||
+             (writable && ftruncate(fd, sizeof(struct ip_snapshot_data)) == 0));
+
+  void *data = ok ? mmap(NULL, sizeof(struct ip_snapshot_data), writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                         MAP_SHARED, fd, 0)
+                  : MAP_FAILED;
+
+  // The mapping outlives the descriptor; the writer keeps it for the lock.
+  if (data == MAP_FAILED || !writable) close(fd);
+
+  if (data == MAP_FAILED) return false;
+
+  *snapshot = (IpSnapshot) { .data = data, .lock_fd = writable ? fd : -1, .writable = writable };
+
+  return true;
+}
+
+bool ip_snapshot_open_writer(IpSnapshot *snapshot, const char *path) {
+  if (!map(snapshot, path, true)) return false;
+
+  struct ip_snapshot_data *d = snapshot->data;
+
+  // Keep the sequence across restarts so readers never see it go back, but
+  // start even in case a previous writer died mid-publish. Holding the lock
+  // means no live writer can be halfway through one.
+  if (atomic_load(&d->header) != HEADER) {
+    atomic_store(&d->seq, 0);
+    atomic_store(&d->header, HEADER);
+  } else if (atomic_load(&d->seq) & 1) {
+    atomic_fetch_add(&d->seq, 1);
+  }
+
+  return true;
+}
+
+bool ip_snapshot_open_reader(IpSnapshot *snapshot, const char *path) { return map(snapshot, path, false); }
+
+void ip_snapshot_close(IpSnapshot *snapshot) {
+  if (snapshot->data) munmap(snapshot->data, sizeof(struct ip_snapshot_data));
+  if (snapshot->data && snapshot->lock_fd >= 0) close(snapshot->lock_fd);
+
+  snapshot->data = NULL;
+  snapshot->lock_fd = -1;
+}
+
+bool ip_snapshot_publish(IpSnapshot *snapshot, const char *ipv4, const char *ipv6) {
+  if (!snapshot->data || !snapshot->writable) return false;
+
+  struct in_addr v4;
+  struct in6_addr v6;
+  uint64_t v6_words[2] = { 0, 0 };
+
+  bool has_v4 = ipv4 && inet_pton(AF_INET, ipv4, &v4) == 1;
+  bool has_v6 = ipv6 && inet_pton(AF_INET6, ipv6, &v6) == 1;
+
+  if (!has_v4 && !has_v6) return false;
+
+  if (has_v6) memcpy(v6_words, v6.s6_addr, sizeof(v6_words));
+
+  struct timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
+
+  struct ip_snapshot_data *d = snapshot->data;
+  uint64_t seq = atomic_load_explicit(&d->seq, memory_order_relaxed);
+
+  // Odd sequence first: the release fence keeps the field stores after it.
+  atomic_store_explicit(&d->seq, seq + 1, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+
+  atomic_store_explicit(&d->detected_ns, (uint64_t) now.tv_sec * NS_PER_SEC + (uint64_t) now.tv_nsec,
+                        memory_order_relaxed);
+  atomic_store_explicit(&d->ipv4, has_v4 ? IPV4_PRESENT | v4.s_addr : 0, memory_order_relaxed);
+  atomic_store_explicit(&d->ipv6_present, has_v6, memory_order_relaxed);
+  atomic_store_explicit(&d->ipv6[0], v6_words[0], memory_order_relaxed);
+  atomic_store_explicit(&d->ipv6[1], v6_words[1], memory_order_relaxed);
+  atomic_store_explicit(&d->writer_pid, (uint64_t) getpid(), memory_order_relaxed);
+
+  atomic_store_explicit(&d->seq, seq + 2, memory_order_release);
+
+  return true;
+}
+
+bool ip_snapshot_read(const IpSnapshot *snapshot, IpSnapshotValue *value) {
+  struct ip_snapshot_data *d = snapshot->data;
+  if (!d || atomic_load_explicit(&d->header, memory_order_acquire) != HEADER) return false;
+
+  uint64_t before, after, detected_ns, ipv4, ipv6_present, v6_words[2], pid;
+  unsigned int attempts = 0;
+
+  do {
+    if (attempts++ == IP_SNAPSHOT_READ_RETRIES) return false;
+
+    before = atomic_load_explicit(&d->seq, memory_order_acquire);
+
+    detected_ns = atomic_load_explicit(&d->detected_ns, memory_order_relaxed);
+    ipv4 = atomic_load_explicit(&d->ipv4, memory_order_relaxed);
+    ipv6_present = atomic_load_explicit(&d->ipv6_present, memory_order_relaxed);
+    v6_words[0] = atomic_load_explicit(&d->ipv6[0], memory_order_relaxed);
+    v6_words[1] = atomic_load_explicit(&d->ipv6[1], memory_order_relaxed);
+    pid = atomic_load_explicit(&d->writer_pid, memory_order_relaxed);
+
+    // Keeps the field loads before the re-check.
+    atomic_thread_fence(memory_order_acquire);
+    after = atomic_load_explicit(&d->seq, memory_order_relaxed);
+  } while ((before & 1) || before != after);
+
+  if (before == 0) return false;
+
+  *value = (IpSnapshotValue) { .sequence = before / 2, .detected_ns = detected_ns, .writer_pid = (uint32_t) pid };
+
+  if (ipv4 & IPV4_PRESENT) {
+    struct in_addr v4 = { .s_addr = (uint32_t) ipv4 };
+    inet_ntop(AF_INET, &v4, value->ipv4, sizeof(value->ipv4));
+  }
+
+  if (ipv6_present) {
+    struct in6_addr v6;
+    memcpy(v6.s6_addr, v6_words, sizeof(v6_words));
+    inet_ntop(AF_INET6, &v6, value->ipv6, sizeof(value->ipv6));
+  }
+
+  return true;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <arpa/inet.h>
+#include <stdatomic.h>
+
+#include "../common.h"
+
+// The last detected public IP in a small file mapped shared (normally on
+// /dev/shm), guarded by a seqlock: one writer, any number of readers in any
+// process, and readers never block or write. A reader retries only if it
+// raced a publish. The single writer is enforced with an exclusive flock()
+// held for as long as the writer keeps the file open.
+#define IP_SNAPSHOT_MAGIC 0x50494643u  // "CFIP"
+#define IP_SNAPSHOT_VERSION 1u
+#define IP_SNAPSHOT_READ_RETRIES 1000
+
+// Every field is a 64-bit atomic so a torn read is impossible per word and
+// the layout is identical for every reader.
+struct ip_snapshot_data {
+  _Atomic uint64_t header;        // magic << 32 | version
+  _Atomic uint64_t seq;           // odd while a publish is in progress
+  _Atomic uint64_t detected_ns;   // CLOCK_REALTIME
+  _Atomic uint64_t ipv4;          // bit 32 = present, low 32 bits = address (network order)
+  _Atomic uint64_t ipv6_present;
+  _Atomic uint64_t ipv6[2];
+  _Atomic uint64_t writer_pid;
+};
+
+struct ip_snapshot {
+  struct ip_snapshot_data *data;
+  int lock_fd;  // writer only, -1 otherwise
+  bool writable;
+};
+
+typedef struct ip_snapshot IpSnapshot;
+
+struct ip_snapshot_value {
+  uint64_t sequence;  // number of publishes so far
+  uint64_t detected_ns;
+  uint32_t writer_pid;
+  char ipv4[INET_ADDRSTRLEN];  // "" when not known
+  char ipv6[INET6_ADDRSTRLEN];
+};
+
+typedef struct ip_snapshot_value IpSnapshotValue;
+
+// Creates (or reuses) the file with mode 0644. Fails while another process
+// holds it for writing. Readers of a file with an older layout see it as
+// empty until the first publish.
+bool ip_snapshot_open_writer(IpSnapshot *snapshot, const char *path);
+
+bool ip_snapshot_open_reader(IpSnapshot *snapshot, const char *path);
+
+void ip_snapshot_close(IpSnapshot *snapshot);
+
+// Either address may be NULL or "" (unknown). Returns false if neither
+// parses.
+bool ip_snapshot_publish(IpSnapshot *snapshot, const char *ipv4, const char *ipv6);
+
+// False if nothing was published yet, the file is not a snapshot, or the
+// sequence stayed odd for IP_SNAPSHOT_READ_RETRIES attempts (a writer that
+// died mid-publish).
+bool ip_snapshot_read(const IpSnapshot *snapshot, IpSnapshotValue *value);
@@ -0,0 +1,78 @@
+#include "live_config.h"
+
+static _Atomic(LiveConfig *) live = NULL;
+static atomic_flag live_lock = ATOMIC_FLAG_INIT;
+static uint64_t next_generation = 1;
+
+static void free_snapshot(LiveConfig *cfg) {
+  env_cleanup(&cfg->env);
+  env_file_free(&cfg->source);
+  mm_free(cfg);
+}
+
+static const char *lookup_snapshot(const void *source, const char *key) {
+  return live_config_get(source, key);
+}
+
+LiveConfig *live_config_load(const char *env_file) {
+  LiveConfig *cfg = mm_calloc(1, sizeof(LiveConfig));
+  if (error_has(ERR_ALLOC_FAILURE)) return NULL;
+
+  atomic_init(&cfg->refs, 1);
+
+  if (env_file) {
+    cfg->source = parse_env_file(env_file);
+
+    if (error_has(ERR_INVALID_ENV_FILE) || error_has(ERR_ALLOC_FAILURE)) {
+      free_snapshot(cfg);
+      return NULL;
+    }
+  }
+
+  env_init(&cfg->env, lookup_snapshot, cfg);
+
+  if (env_domains(&cfg->env).length == 0 || error_has(ERR_INVALID_ENV_DOMAINS)) {
+    free_snapshot(cfg);
+    return NULL;
+  }
+
+  return cfg;
+}
+
+const char *live_config_get(const LiveConfig *cfg, const char *key) {
+  const char *value = cfg ? env_file_get(&cfg->source, key) : NULL;
+
+  return value ? value : getenv(key);
+}
+
+static inline void lock_live(void) { while (atomic_flag_test_and_set_explicit(&live_lock, memory_order_acquire)) {} }
+
+static inline void unlock_live(void) { atomic_flag_clear_explicit(&live_lock, memory_order_release); }
+
+void live_config_publish(LiveConfig *cfg) {
+  // Only the reload path publishes, so the generation needs no atomics.
+  cfg->generation = next_generation++;
+
+  lock_live();
+  LiveConfig *old = atomic_exchange_explicit(&live, cfg, memory_order_acq_rel);
+  unlock_live();
+
+  if (old) live_config_release(old);
+}
+
+LiveConfig *live_config_acquire(void) {
+  // The lock only covers load + increment, so a publisher can never free the
+  // snapshot between a reader seeing it and pinning it.
+  lock_live();
+  LiveConfig *cfg = atomic_load_explicit(&live, memory_order_acquire);
+  if (cfg) atomic_fetch_add_explicit(&cfg->refs, 1, memory_order_relaxed);
+  unlock_live();
+
+  return cfg;
+}
+
+void live_config_release(LiveConfig *cfg) {
+  if (!cfg) return;
+
+  if (atomic_fetch_sub_explicit(&cfg->refs, 1, memory_order_acq_rel) == 1) free_snapshot(cfg);
+}
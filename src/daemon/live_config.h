@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdatomic.h>
+
+#include "../common.h"
+#include "../errors/errors.h"
+#include "../memory/memory_management.h"
+#include "../utils/meta_array.h"
+#include "../env/env.h"
+#include "../env/env_parser.h"
+
+// Immutable configuration snapshot. Readers pin the current one for a whole
+// update cycle; a reload publishes a replacement and the old snapshot is
+// reclaimed once its last reader releases it (RCU-style).
+struct live_config {
+  atomic_uint refs;
+  uint64_t generation;
+  EnvFile source;
+  Env env;
+};
+
+typedef struct live_config LiveConfig;
+
+// Builds a snapshot from `env_file` (NULL = process environment only). Only
+// the domain list is resolved up front (the reload diff needs it); every
+// other setting is parsed lazily through `env`. Returns NULL and sets error
+// flags when the file or the domain list is invalid.
+LiveConfig *live_config_load(const char *env_file);
+
+// Looks `key` up in the snapshot's env file, falling back to getenv().
+const char *live_config_get(const LiveConfig *cfg, const char *key);
+
+// Atomically replaces the live snapshot; the previous one is released.
+void live_config_publish(LiveConfig *cfg);
+
+// Pins the live snapshot (NULL before the first publish).
+LiveConfig *live_config_acquire(void);
+
+void live_config_release(LiveConfig *cfg);
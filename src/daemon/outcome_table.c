@@ -0,0 +1,115 @@
+#include "outcome_table.h"
+
+#define BITS_PER_WORD 64
+
+static inline size_t word_of(size_t idx) { return idx / BITS_PER_WORD; }
+
+static inline uint64_t bit_of(size_t idx) { return 1ull << (idx % BITS_PER_WORD); }
+
+// Columns ordered by decreasing alignment so the block needs no padding.
+static size_t block_size(size_t length, size_t words) {
+  return OUTCOME_SET_COUNT * words * sizeof(uint64_t)
+         + length * (sizeof(uint32_t) + sizeof(ErrorFlags) + sizeof(uint16_t) + 2 * sizeof(uint8_t));
+}
+
+bool outcome_table_init(OutcomeTable *table, size_t length) {
+  memset(table, 0, sizeof(*table));
+
+  size_t words = (length + BITS_PER_WORD - 1) / BITS_PER_WORD;
+  char *block = mm_calloc(1, block_size(length, words) + 1);
+  if (!block) return false;
+
+  char *cursor = block;
+
+  for (size_t set = 0; set < OUTCOME_SET_COUNT; set++) {
+    table->bits[set] = (_Atomic uint64_t *) cursor;
+    cursor += words * sizeof(uint64_t);
+  }
+
+  table->latency_us = (uint32_t *) cursor;
+  cursor += length * sizeof(uint32_t);
+  table->errors = (ErrorFlags *) cursor;
+  cursor += length * sizeof(ErrorFlags);
+  table->http_code = (uint16_t *) cursor;
+  cursor += length * sizeof(uint16_t);
+  table->status = (uint8_t *) cursor;
+  cursor += length;
+  table->attempts = (uint8_t *) cursor;
+
+  table->length = length;
+  table->words = words;
+  table->block = block;
+
+  return true;
+}
+
+void outcome_table_reset(OutcomeTable *table) {
+  if (!table->block) return;
+
+  memset(table->block, 0, block_size(table->length, table->words));
+}
+
+static inline void set_bit(OutcomeTable *table, outcome_set_t set, size_t idx, bool on) {
+  _Atomic uint64_t *word = &table->bits[set][word_of(idx)];
+
+  if (on) {
+    atomic_fetch_or_explicit(word, bit_of(idx), memory_order_relaxed);
+  } else {
+    atomic_fetch_and_explicit(word, ~bit_of(idx), memory_order_relaxed);
+  }
+}
+
+void outcome_record(OutcomeTable *table, size_t idx, outcome_status_t status, uint16_t http_code,
+                    uint32_t latency_us, ErrorFlags errors) {
+  if (idx >= table->length) return;
+
+  table->status[idx] = (uint8_t) status;
+  table->http_code[idx] = http_code;
+  table->latency_us[idx] = latency_us;
+  table->errors[idx] = errors;
+  if (table->attempts[idx] < UINT8_MAX) table->attempts[idx]++;
+
+  set_bit(table, OUTCOME_SET_FAILED, idx, status == OUTCOME_FAILED);
+  set_bit(table, OUTCOME_SET_CHANGED, idx, status == OUTCOME_UPDATED || status == OUTCOME_CREATED);
+  set_bit(table, OUTCOME_SET_SKIPPED, idx, status == OUTCOME_SKIPPED);
+}
+
+size_t outcome_count(const OutcomeTable *table, outcome_set_t set) {
+  size_t count = 0;
+
+  for (size_t w = 0; w < table->words; w++) {
+    count += (size_t) __builtin_popcountll(atomic_load_explicit(&table->bits[set][w], memory_order_relaxed));
+  }
+
+  return count;
+}
+
+size_t outcome_next(const OutcomeTable *table, outcome_set_t set, size_t from) {
+  if (from >= table->length) return table->length;
+
+  size_t w = word_of(from);
+  uint64_t word = atomic_load_explicit(&table->bits[set][w], memory_order_relaxed) & (~0ull << (from % BITS_PER_WORD));
+
+  for (;;) {
+    if (word) return MIN(w * BITS_PER_WORD + (size_t) __builtin_ctzll(word), table->length);
+    if (++w >= table->words) return table->length;
+
+    word = atomic_load_explicit(&table->bits[set][w], memory_order_relaxed);
+  }
+}
+
+OutcomeSummary outcome_summarize(const OutcomeTable *table) {
+  OutcomeSummary summary = { .total = table->length, .counts = { 0 }, .max_latency_us = 0 };
+
+  for (size_t set = 0; set < OUTCOME_SET_COUNT; set++) summary.counts[set] = outcome_count(table, set);
+
+  // Latency is a dense column: a straight scan the compiler can vectorize.
+  for (size_t i = 0; i < table->length; i++) summary.max_latency_us = MAX(summary.max_latency_us, table->latency_us[i]);
+
+  return summary;
+}
+
+void outcome_table_free(OutcomeTable *table) {
+  mm_free(table->block);
+  memset(table, 0, sizeof(*table));
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <stdatomic.h>
+
+#include "../common.h"
+#include "../errors/errors.h"
+#include "../memory/memory_management.h"
+
+typedef enum {
+  OUTCOME_PENDING,
+  OUTCOME_UNCHANGED,  // record already pointed at the current IP
+  OUTCOME_UPDATED,
+  OUTCOME_CREATED,
+  OUTCOME_SKIPPED,    // not attempted this cycle (e.g. IP unchanged)
+  OUTCOME_FAILED,
+} outcome_status_t;
+
+typedef enum {
+  OUTCOME_SET_FAILED,
+  OUTCOME_SET_CHANGED,  // updated or created
+  OUTCOME_SET_SKIPPED,
+  OUTCOME_SET_COUNT
+} outcome_set_t;
+
+// Per-cycle results as a structure of arrays, indexed like the DomainTable.
+// Retry passes and summaries walk the bitmaps (popcount / count-trailing-
+// zeros) instead of touching every row. Workers may record distinct rows
+// concurrently: each row is owned by one worker and bitmap words are only
+// changed with atomic or/and.
+struct outcome_table {
+  size_t length;
+  size_t words;
+  uint8_t *status;
+  uint8_t *attempts;
+  uint16_t *http_code;
+  uint32_t *latency_us;
+  ErrorFlags *errors;
+  _Atomic uint64_t *bits[OUTCOME_SET_COUNT];
+  void *block;
+};
+
+typedef struct outcome_table OutcomeTable;
+
+struct outcome_summary {
+  size_t total;
+  size_t counts[OUTCOME_SET_COUNT];
+  uint32_t max_latency_us;
+};
+
+typedef struct outcome_summary OutcomeSummary;
+
+// One allocation holds every column.
+bool outcome_table_init(OutcomeTable *table, size_t length);
+
+// Clears every row for a new cycle (attempt counts included).
+void outcome_table_reset(OutcomeTable *table);
+
+// Records one attempt for row `idx`; a later success clears the failed bit.
+void outcome_record(OutcomeTable *table, size_t idx, outcome_status_t status, uint16_t http_code,
+                    uint32_t latency_us, ErrorFlags errors);
+
+size_t outcome_count(const OutcomeTable *table, outcome_set_t set);
+
+// Next row >= `from` that is in `set`, or table->length when none is left.
+size_t outcome_next(const OutcomeTable *table, outcome_set_t set, size_t from);
+
+#define OUTCOME_FOREACH(table, set, idx) \
+  for (size_t idx = outcome_next((table), (set), 0); idx < (table)->length; idx = outcome_next((table), (set), idx + 1))
+
+OutcomeSummary outcome_summarize(const OutcomeTable *table);
+
+void outcome_table_free(OutcomeTable *table);
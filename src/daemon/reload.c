@@ -0,0 +1,90 @@
+#include "reload.h"
+
+#include "../env/config_check.h"
+#include "../logging/log.h"
+#include "../tracing/trace.h"
+
+// The same format checks as at startup: a typo in a reloaded value would
+// otherwise run silently on its default. Each failed setting is logged.
+static bool check_settings(LiveConfig *cfg) {
+  ValidationReport report;
+  bool ok = validate_configuration(&cfg->env, NULL, &report);
+
+  for (size_t i = 0; i < report.length; i++) {
+    if (report.items[i].status == CHECK_FAILED) LOG(LOG_MSG_RELOAD_INVALID_SETTING, report.items[i].subject);
+  }
+
+  report_free(&report);
+
+  return ok;
+}
+
+static DomainDelta reload_in_scope(const char *env_file, DomainTable *table) {
+  DomainDelta delta = { .added = 0, .removed = 0, .kept = 0 };
+
+  LiveConfig *next = live_config_load(env_file);
+
+  if (!next) {
+    error_set(ERR_RELOAD);
+    return delta;
+  }
+
+  if (!check_settings(next)) {
+    live_config_release(next);
+    error_set(ERR_RELOAD);
+    return delta;
+  }
+
+  MetaArray domains = env_domains(&next->env);
+
+  TRACE_BEGIN(diff, TRACE_DIFF);
+  delta = domain_table_apply(table, domains.data, domains.length);
+  TRACE_END(diff);
+
+  if (error_has(ERR_ALLOC_FAILURE)) {
+    live_config_release(next);
+    error_set(ERR_RELOAD);
+    return delta;
+  }
+
+  // Cycles already running keep the snapshot they pinned.
+  live_config_publish(next);
+
+  return delta;
+}
+
+DomainDelta daemon_reload(const char *env_file, DomainTable *table) {
+  // A fresh scope so flags left over from earlier cycles cannot make this
+  // reload look failed; whatever it records is handed back to the caller.
+  ErrorContext ctx;
+  error_scope_begin(&ctx);
+
+  DomainDelta delta = reload_in_scope(env_file, table);
+
+  ErrorFlags flags = error_scope_end(&ctx);
+  if (flags) error_set((CombinedErrorCode) flags);
+
+  return delta;
+}
+
+bool daemon_reload_if_requested(const char *env_file, DomainTable *table, DomainDelta *delta) {
+  if (!signals_take_reload()) return false;
+
+  ErrorContext ctx;
+  error_scope_begin(&ctx);
+
+  DomainDelta applied = daemon_reload(env_file, table);
+  if (delta) *delta = applied;
+
+  ErrorFlags flags = error_scope_end(&ctx);
+
+  if (flags & ERR_RELOAD) {
+    LOG(LOG_MSG_RELOAD_FAILED, NULL, flags);
+    error_set((CombinedErrorCode) flags);
+    return false;
+  }
+
+  LOG(LOG_MSG_RELOAD_APPLIED, NULL, applied.added, applied.removed, applied.kept);
+
+  return true;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "../common.h"
+#include "../errors/errors.h"
+#include "../signals/signal_processing.h"
+#include "live_config.h"
+#include "domain_table.h"
+
+// Re-reads and format-checks the configuration, applies only the domain
+// delta to `table` and publishes the new snapshot. On any failure (including
+// an invalid setting, which is logged) the running config and the table are
+// kept as they were and ERR_RELOAD is set.
+DomainDelta daemon_reload(const char *env_file, DomainTable *table);
+
+// Runs daemon_reload() if a SIGHUP arrived since the last call.
+bool daemon_reload_if_requested(const char *env_file, DomainTable *table, DomainDelta *delta);
@@ -0,0 +1,68 @@
+#include "schedule_jitter.h"
+
+#include <unistd.h>
+
+#define FNV_OFFSET 0xcbf29ce484222325ull
+#define FNV_PRIME 0x100000001b3ull
+
+static uint64_t splitmix64(uint64_t x) {
+  x += 0x9e3779b97f4a7c15ull;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+  return x ^ (x >> 31);
+}
+
+static uint64_t fnv1a(uint64_t hash, const char *text) {
+  for (; *text; text++) hash = (hash ^ (unsigned char) *text) * FNV_PRIME;
+
+  return hash;
+}
+
+static uint64_t compute_host_hash(void) {
+  const char *override = getenv(HOST_ID_ENV_VAR);
+  if (override && *override) return splitmix64(fnv1a(FNV_OFFSET, override));
+
+  char machine_id[64] = "", hostname[256] = "";
+
+  FILE *file = fopen(MACHINE_ID_PATH, "r");
+
+  if (file) {
+    if (!fgets(machine_id, sizeof(machine_id), file)) machine_id[0] = '\0';
+    fclose(file);
+  }
+
+  if (gethostname(hostname, sizeof(hostname) - 1) != 0) hostname[0] = '\0';
+
+  uint64_t hash = fnv1a(fnv1a(FNV_OFFSET, machine_id), "\n");
+
+  return splitmix64(fnv1a(hash, hostname));
+}
+
+uint64_t host_hash(void) {
+  // Loop thread only; computing it twice would give the same value anyway.
+  static uint64_t cached = 0;
+  static bool computed = false;
+
+  if (!computed) {
+    cached = compute_host_hash();
+    computed = true;
+  }
+
+  return cached;
+}
+
+uint64_t jitter_ns(jitter_purpose_t purpose, uint64_t span_ns) {
+  if (span_ns == 0) return 0;
+
+  return splitmix64(host_hash() + (uint64_t) purpose) % span_ns;
+}
+
+uint64_t jitter_next_slot_ns(uint64_t after_ns, uint64_t interval_ns) {
+  if (interval_ns == 0) return after_ns;
+
+  uint64_t phase = jitter_ns(JITTER_INTERVAL_PHASE, interval_ns);
+  if (after_ns < phase) return phase;
+
+  // The latest slot at or before `after_ns`, plus one interval.
+  return after_ns - (after_ns - phase) % interval_ns + interval_ns;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "../common.h"
+
+// Deterministic per-host spreading, so a fleet sharing one interval does not
+// wake all at once. Every value derives from a host hash: the same host
+// always gets the same offsets (across restarts too), and different hosts
+// are spread uniformly.
+typedef enum {
+  JITTER_INTERVAL_PHASE,
+  JITTER_STARTUP,
+  JITTER_NETLINK,
+} jitter_purpose_t;
+
+// Hash of $HOST_ID if set, else of /etc/machine-id plus the hostname (the
+// hostname tells apart containers and clones sharing an image's
+// machine-id). Computed once.
+uint64_t host_hash(void);
+
+// Offset in [0, span_ns) for `purpose`; independent across purposes.
+uint64_t jitter_ns(jitter_purpose_t purpose, uint64_t span_ns);
+
+// The first wall-clock time after `after_ns` (CLOCK_REALTIME) that falls on
+// this host's phase of `interval_ns`. Instances with the same interval keep
+// their relative spread indefinitely, whatever their start times.
+uint64_t jitter_next_slot_ns(uint64_t after_ns, uint64_t interval_ns);
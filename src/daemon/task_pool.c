@@ -0,0 +1,360 @@
+#include "task_pool.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "../memory/memory_management.h"
+
+#define DEQUE_MASK (TASK_POOL_DEQUE_CAPACITY - 1)
+#define CACHE_LINE 64
+
+// Chase-Lev deque (the C11 formulation by Lê et al.): the owner pushes and
+// pops at `bottom`, thieves take from `top`, and only the last element is
+// contended.
+struct deque {
+  _Alignas(CACHE_LINE) atomic_llong top;
+  _Alignas(CACHE_LINE) atomic_llong bottom;
+  _Atomic(PoolTask *) buffer[TASK_POOL_DEQUE_CAPACITY];
+};
+
+typedef struct deque Deque;
+
+struct worker {
+  Deque deque;
+  TaskPool *pool;
+  pthread_t thread;
+  uint64_t rng;
+};
+
+typedef struct worker Worker;
+
+struct task_pool {
+  Worker *workers;
+  size_t count;    // fixed before any thread starts
+  size_t started;  // threads actually running
+
+  pthread_mutex_t lock;
+  pthread_cond_t wake;
+  PoolTask *inject_head;
+  PoolTask *inject_tail;
+  atomic_size_t queued;  // submitted and not yet taken by a worker
+  atomic_size_t sleepers;
+  bool stopping;
+
+  _Atomic(PoolTask *) finished;  // LIFO, reversed on completion
+  int event_fd;
+
+  atomic_uint_fast64_t executed;
+  atomic_uint_fast64_t stolen;
+  atomic_uint_fast64_t injected;
+};
+
+static _Thread_local Worker *current_worker = NULL;
+
+static bool deque_push(Deque *d, PoolTask *task) {
+  long long b = atomic_load_explicit(&d->bottom, memory_order_relaxed);
+  long long t = atomic_load_explicit(&d->top, memory_order_acquire);
+
+  if (b - t >= TASK_POOL_DEQUE_CAPACITY) return false;
+
+  atomic_store_explicit(&d->buffer[b & DEQUE_MASK], task, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+  atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+
+  return true;
+}
+
+static PoolTask *deque_pop(Deque *d) {
+  long long b = atomic_load_explicit(&d->bottom, memory_order_relaxed) - 1;
+  atomic_store_explicit(&d->bottom, b, memory_order_relaxed);
+  atomic_thread_fence(memory_order_seq_cst);
+  long long t = atomic_load_explicit(&d->top, memory_order_relaxed);
+
+  if (t > b) {
+    atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+    return NULL;
+  }
+
+  PoolTask *task = atomic_load_explicit(&d->buffer[b & DEQUE_MASK], memory_order_relaxed);
+
+  if (t == b) {
+    // Last element: race the thieves for it.
+    if (!atomic_compare_exchange_strong_explicit(&d->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed)) {
+      task = NULL;
+    }
+
+    atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+  }
+
+  return task;
+}
+
+static PoolTask *deque_steal(Deque *d) {
+  long long t = atomic_load_explicit(&d->top, memory_order_acquire);
+  atomic_thread_fence(memory_order_seq_cst);
+  long long b = atomic_load_explicit(&d->bottom, memory_order_acquire);
+
+  if (t >= b) return NULL;
+
+  PoolTask *task = atomic_load_explicit(&d->buffer[t & DEQUE_MASK], memory_order_relaxed);
+
+  if (!atomic_compare_exchange_strong_explicit(&d->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed)) {
+    return NULL;
+  }
+
+  return task;
+}
+
+static PoolTask *inject_take(TaskPool *pool) {
+  pthread_mutex_lock(&pool->lock);
+
+  PoolTask *task = pool->inject_head;
+
+  if (task) {
+    pool->inject_head = task->next;
+    if (!pool->inject_head) pool->inject_tail = NULL;
+  }
+
+  pthread_mutex_unlock(&pool->lock);
+
+  return task;
+}
+
+static void inject_put(TaskPool *pool, PoolTask *task) {
+  task->next = NULL;
+
+  pthread_mutex_lock(&pool->lock);
+
+  if (pool->inject_tail) {
+    pool->inject_tail->next = task;
+  } else {
+    pool->inject_head = task;
+  }
+
+  pool->inject_tail = task;
+
+  pthread_mutex_unlock(&pool->lock);
+}
+
+static void wake_one(TaskPool *pool) {
+  if (atomic_load(&pool->sleepers) == 0) return;
+
+  pthread_mutex_lock(&pool->lock);
+  pthread_cond_signal(&pool->wake);
+  pthread_mutex_unlock(&pool->lock);
+}
+
+static void finish(TaskPool *pool, PoolTask *task) {
+  PoolTask *head = atomic_load(&pool->finished);
+
+  do {
+    task->next = head;
+  } while (!atomic_compare_exchange_weak(&pool->finished, &head, task));
+
+  // Only the push onto an empty list needs a wakeup: task_pool_complete()
+  // takes the whole list after reading the eventfd.
+  if (!head) {
+    uint64_t one = 1;
+    ssize_t written = write(pool->event_fd, &one, sizeof(one));
+    (void) written;
+  }
+}
+
+static void execute(TaskPool *pool, PoolTask *task) {
+  task->run(task);
+  atomic_fetch_add_explicit(&pool->executed, 1, memory_order_relaxed);
+  finish(pool, task);
+}
+
+// Own deque first (hot in cache), then the injection queue, then a sweep
+// over the other workers starting at a random victim.
+static PoolTask *find_task(Worker *self) {
+  TaskPool *pool = self->pool;
+  PoolTask *task = deque_pop(&self->deque);
+
+  if (!task) task = inject_take(pool);
+
+  if (!task && pool->count > 1) {
+    self->rng ^= self->rng << 13;
+    self->rng ^= self->rng >> 7;
+    self->rng ^= self->rng << 17;
+
+    size_t start = self->rng % pool->count;
+
+    for (size_t i = 0; i < pool->count && !task; i++) {
+      Worker *victim = &pool->workers[(start + i) % pool->count];
+      if (victim == self) continue;
+
+      task = deque_steal(&victim->deque);
+      if (task) atomic_fetch_add_explicit(&pool->stolen, 1, memory_order_relaxed);
+    }
+  }
+
+  if (task) atomic_fetch_sub(&pool->queued, 1);
+
+  return task;
+}
+
+static void *worker_loop(void *arg) {
+  Worker *self = arg;
+  TaskPool *pool = self->pool;
+
+  current_worker = self;
+
+  for (;;) {
+    PoolTask *task = find_task(self);
+
+    if (task) {
+      execute(pool, task);
+      continue;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+
+    // Announce the sleep before re-checking, so a concurrent submit either
+    // sees the sleeper or its task is seen here.
+    atomic_fetch_add(&pool->sleepers, 1);
+
+    bool idle = atomic_load(&pool->queued) == 0;
+
+    if (idle && pool->stopping) {
+      atomic_fetch_sub(&pool->sleepers, 1);
+      pthread_mutex_unlock(&pool->lock);
+      break;
+    }
+
+    if (idle) pthread_cond_wait(&pool->wake, &pool->lock);
+
+    atomic_fetch_sub(&pool->sleepers, 1);
+    pthread_mutex_unlock(&pool->lock);
+  }
+
+  current_worker = NULL;
+
+  return NULL;
+}
+
+TaskPool *task_pool_create(size_t workers) {
+  if (workers == 0) {
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    workers = online > 0 ? (size_t) online : 1;
+  }
+
+  workers = MIN(workers, (size_t) TASK_POOL_MAX_WORKERS);
+
+  TaskPool *pool = mm_calloc(1, sizeof(TaskPool));
+  if (!pool) return NULL;
+
+  // Cache-line aligned deques; calloc only guarantees max_align_t.
+  if (posix_memalign((void **) &pool->workers, CACHE_LINE, workers * sizeof(Worker)) != 0) {
+    error_set(ERR_ALLOC_FAILURE);
+    mm_free(pool);
+    return NULL;
+  }
+
+  memset(pool->workers, 0, workers * sizeof(Worker));
+
+  pool->event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+  if (pool->event_fd < 0) {
+    free(pool->workers);
+    mm_free(pool);
+    return NULL;
+  }
+
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->wake, NULL);
+
+  pool->count = workers;
+
+  for (size_t i = 0; i < workers; i++) {
+    pool->workers[i].pool = pool;
+    pool->workers[i].rng = 0x9e3779b97f4a7c15ull * (i + 1);
+  }
+
+  // A worker that failed to start just has an empty deque to steal from.
+  while (pool->started < workers &&
+         pthread_create(&pool->workers[pool->started].thread, NULL, worker_loop, &pool->workers[pool->started]) == 0) {
+    pool->started++;
+  }
+
+  return pool;
+}
+
+void task_pool_submit(TaskPool *pool, PoolTask *task) {
+  if (pool->started == 0) {
+    execute(pool, task);
+    return;
+  }
+
+  atomic_fetch_add(&pool->queued, 1);
+
+  Worker *self = current_worker;
+
+  if (!self || self->pool != pool || !deque_push(&self->deque, task)) {
+    atomic_fetch_add_explicit(&pool->injected, 1, memory_order_relaxed);
+    inject_put(pool, task);
+  }
+
+  wake_one(pool);
+}
+
+int task_pool_fd(const TaskPool *pool) { return pool->event_fd; }
+
+size_t task_pool_complete(TaskPool *pool) {
+  uint64_t ignored;
+  ssize_t n = read(pool->event_fd, &ignored, sizeof(ignored));
+  (void) n;
+
+  PoolTask *list = atomic_exchange(&pool->finished, NULL);
+  PoolTask *ordered = NULL;
+
+  while (list) {
+    PoolTask *next = list->next;
+    list->next = ordered;
+    ordered = list;
+    list = next;
+  }
+
+  size_t count = 0;
+
+  while (ordered) {
+    PoolTask *task = ordered;
+    ordered = task->next;
+
+    if (task->done) task->done(task);
+    count++;
+  }
+
+  return count;
+}
+
+void task_pool_stats(const TaskPool *pool, TaskPoolStats *stats) {
+  *stats = (TaskPoolStats) {
+      .workers = pool->started,
+      .executed = atomic_load_explicit(&pool->executed, memory_order_relaxed),
+      .stolen = atomic_load_explicit(&pool->stolen, memory_order_relaxed),
+      .injected = atomic_load_explicit(&pool->injected, memory_order_relaxed),
+  };
+}
+
+void task_pool_destroy(TaskPool *pool) {
+  if (!pool) return;
+
+  pthread_mutex_lock(&pool->lock);
+  pool->stopping = true;
+  pthread_cond_broadcast(&pool->wake);
+  pthread_mutex_unlock(&pool->lock);
+
+  for (size_t i = 0; i < pool->started; i++) pthread_join(pool->workers[i].thread, NULL);
+
+  task_pool_complete(pool);
+
+  pthread_cond_destroy(&pool->wake);
+  pthread_mutex_destroy(&pool->lock);
+  close(pool->event_fd);
+  free(pool->workers);
+  mm_free(pool);
+}
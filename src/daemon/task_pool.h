@@ -0,0 +1,51 @@
+#pragma once
+
+#include "../common.h"
+
+// Fixed-size worker pool for CPU-side pipeline work (parsing large listings,
+// diffing, building payloads). Each worker owns a bounded deque: tasks it
+// spawns go to the bottom of its own deque and it pops them LIFO, while idle
+// workers steal FIFO from the top of others'. Tasks submitted from outside
+// the pool (the event loop) go through a shared injection queue.
+//
+// Completion is reported back to the event loop: register task_pool_fd()
+// for EPOLLIN and call task_pool_complete(), which runs each finished
+// task's `done` on the loop thread.
+struct pool_task {
+  void (*run)(struct pool_task *task);   // on a worker
+  void (*done)(struct pool_task *task);  // on the loop thread; may be NULL
+  struct pool_task *next;                // internal
+};
+
+typedef struct pool_task PoolTask;
+
+typedef struct task_pool TaskPool;
+
+struct task_pool_stats {
+  size_t workers;
+  uint64_t executed;
+  uint64_t stolen;
+  uint64_t injected;
+};
+
+typedef struct task_pool_stats TaskPoolStats;
+
+// `workers` = 0 uses the online CPU count; capped at TASK_POOL_MAX_WORKERS.
+// Returns NULL (ERR_ALLOC_FAILURE) if out of memory. If no thread can be
+// started the pool still works: tasks run inline on submission.
+TaskPool *task_pool_create(size_t workers);
+
+// Any thread. From inside a task the new task stays on the current worker.
+void task_pool_submit(TaskPool *pool, PoolTask *task);
+
+int task_pool_fd(const TaskPool *pool);
+
+// Loop thread: runs `done` for every task finished so far, in completion
+// order. Returns how many.
+size_t task_pool_complete(TaskPool *pool);
+
+void task_pool_stats(const TaskPool *pool, TaskPoolStats *stats);
+
+// Lets every queued task finish, stops the workers and runs the remaining
+// `done` callbacks on the calling thread.
+void task_pool_destroy(TaskPool *pool);
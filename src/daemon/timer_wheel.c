@@ -0,0 +1,170 @@
+#include "timer_wheel.h"
+
+#define LEVEL_SHIFT(level) ((level) * TIMER_WHEEL_SLOT_BITS)
+#define SLOT_MASK (TIMER_WHEEL_SLOTS - 1)
+#define WHEEL_SPAN (1ull << LEVEL_SHIFT(TIMER_WHEEL_LEVELS))  // ticks covered by all levels
+
+static void list_init(WheelLink *head) { head->prev = head->next = head; }
+
+static bool list_empty(const WheelLink *head) { return head->next == head; }
+
+static void list_unlink(WheelLink *link) {
+  link->prev->next = link->next;
+  link->next->prev = link->prev;
+  link->prev = link->next = link;
+}
+
+static void list_append(WheelLink *head, WheelLink *link) {
+  link->prev = head->prev;
+  link->next = head;
+  head->prev->next = link;
+  head->prev = link;
+}
+
+// Moves a whole bucket onto `out` and marks it empty.
+static void take_bucket(TimerWheel *wheel, int bucket, WheelLink *out) {
+  WheelLink *head = &wheel->slots[bucket];
+
+  list_init(out);
+  if (list_empty(head)) return;
+
+  out->next = head->next;
+  out->prev = head->prev;
+  out->next->prev = out;
+  out->prev->next = out;
+  list_init(head);
+
+  for (WheelLink *l = out->next; l != out; l = l->next) ((WheelTimer *) l)->bucket = -1;
+
+  wheel->occupied[bucket / TIMER_WHEEL_SLOTS] &= ~(1ull << (bucket % TIMER_WHEEL_SLOTS));
+}
+
+// The level is the lowest one whose higher digits `expires` shares with the
+// current tick: the timer is then reached exactly when that level's digit
+// comes around, and cascades down from there. The top level also takes any
+// timer less than a full wheel away whose higher digits differ: its slot is
+// then at most one rotation ahead, which is still reached in time.
+static void place(TimerWheel *wheel, WheelTimer *timer) {
+  uint64_t expires = MAX(timer->expires, wheel->current);
+  unsigned int level = 0;
+  unsigned int slot;
+
+  if (expires - wheel->current >= WHEEL_SPAN) {
+    // Beyond the wheel: park in the farthest top-level slot, re-placed when
+    // it comes up.
+    level = TIMER_WHEEL_LEVELS - 1;
+    slot = ((wheel->current >> LEVEL_SHIFT(level)) - 1) & SLOT_MASK;
+  } else {
+    while (level < TIMER_WHEEL_LEVELS - 1 &&
+           expires >> LEVEL_SHIFT(level + 1) != wheel->current >> LEVEL_SHIFT(level + 1)) {
+      level++;
+    }
+
+    slot = (expires >> LEVEL_SHIFT(level)) & SLOT_MASK;
+  }
+
+  timer->bucket = (int) (level * TIMER_WHEEL_SLOTS + slot);
+  list_append(&wheel->slots[timer->bucket], &timer->link);
+  wheel->occupied[level] |= 1ull << slot;
+}
+
+// First tick after the current one at which some level has work: a level-0
+// slot to fire or a higher-level slot to cascade. UINT64_MAX when empty.
+static uint64_t next_event(const TimerWheel *wheel) {
+  uint64_t best = UINT64_MAX;
+
+  for (unsigned int level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+    uint64_t mask = wheel->occupied[level];
+    if (!mask) continue;
+
+    uint64_t base = wheel->current >> LEVEL_SHIFT(level);
+    unsigned int from = (unsigned int) (base + 1) & SLOT_MASK;
+    uint64_t rotated = from ? (mask >> from) | (mask << (TIMER_WHEEL_SLOTS - from)) : mask;
+    uint64_t tick = (base + 1 + (uint64_t) __builtin_ctzll(rotated)) << LEVEL_SHIFT(level);
+
+    best = MIN(best, tick);
+  }
+
+  return best;
+}
+
+void timer_wheel_init(TimerWheel *wheel, uint64_t tick_ns, uint64_t now_ns) {
+  *wheel = (TimerWheel) { .origin_ns = now_ns, .tick_ns = tick_ns };
+
+  for (size_t i = 0; i < ARRAY_SIZE(wheel->slots); i++) list_init(&wheel->slots[i]);
+}
+
+void timer_wheel_cancel(TimerWheel *wheel, WheelTimer *timer) {
+  if (!timer->pending) return;
+
+  list_unlink(&timer->link);
+
+  if (timer->bucket >= 0 && list_empty(&wheel->slots[timer->bucket])) {
+    wheel->occupied[timer->bucket / TIMER_WHEEL_SLOTS] &= ~(1ull << (timer->bucket % TIMER_WHEEL_SLOTS));
+  }
+
+  timer->bucket = -1;
+  timer->pending = false;
+  wheel->count--;
+}
+
+void timer_wheel_schedule(TimerWheel *wheel, WheelTimer *timer, uint64_t deadline_ns) {
+  timer_wheel_cancel(wheel, timer);
+
+  // Rounded up: a timer may fire up to a tick late, never early.
+  uint64_t expires = deadline_ns > wheel->origin_ns ? (deadline_ns - wheel->origin_ns + wheel->tick_ns - 1) / wheel->tick_ns : 0;
+
+  timer->expires = MAX(expires, wheel->current + 1);
+  timer->pending = true;
+  wheel->count++;
+
+  place(wheel, timer);
+}
+
+size_t timer_wheel_advance(TimerWheel *wheel, uint64_t now_ns) {
+  uint64_t target = now_ns > wheel->origin_ns ? (now_ns - wheel->origin_ns) / wheel->tick_ns : 0;
+  size_t fired = 0;
+  WheelLink due;
+
+  for (uint64_t tick; (tick = next_event(wheel)) <= target;) {
+    wheel->current = tick;
+
+    // Top-down, so timers cascading several levels land in slots that are
+    // themselves cascaded (or fired) at this same tick.
+    for (unsigned int level = TIMER_WHEEL_LEVELS - 1; level > 0; level--) {
+      if (tick & ((1ull << LEVEL_SHIFT(level)) - 1)) continue;
+
+      take_bucket(wheel, (int) (level * TIMER_WHEEL_SLOTS + ((tick >> LEVEL_SHIFT(level)) & SLOT_MASK)), &due);
+
+      while (!list_empty(&due)) {
+        WheelTimer *timer = (WheelTimer *) due.next;
+        list_unlink(&timer->link);
+        place(wheel, timer);
+      }
+    }
+
+    take_bucket(wheel, (int) (tick & SLOT_MASK), &due);
+
+    // Callbacks may cancel timers still on `due`; cancel() unlinks them.
+    while (!list_empty(&due)) {
+      WheelTimer *timer = (WheelTimer *) due.next;
+      list_unlink(&timer->link);
+
+      timer->pending = false;
+      wheel->count--;
+      fired++;
+
+      timer->callback(timer);
+    }
+  }
+
+  wheel->current = MAX(wheel->current, target);
+
+  return fired;
+}
+
+uint64_t timer_wheel_next_ns(const TimerWheel *wheel) {
+  uint64_t tick = next_event(wheel);
+
+  return tick == UINT64_MAX ? 0 : wheel->origin_ns + tick * wheel->tick_ns;
+}
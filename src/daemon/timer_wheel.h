@@ -0,0 +1,74 @@
+#pragma once
+
+#include "../common.h"
+
+// Hierarchical timer wheel: TIMER_WHEEL_LEVELS levels of 64 slots, each
+// level 64 times coarser than the one below. Scheduling and cancelling are
+// O(1) (a list splice plus a bitmap bit); timers move down a level only when
+// their slot comes up, and empty stretches are skipped with the occupancy
+// bitmaps, so advancing after a long idle period does not walk every tick.
+//
+// The wheel does not own a clock or a timer: the caller advances it with the
+// current CLOCK_MONOTONIC time and arms one timerfd at timer_wheel_next_ns().
+// Resolution is one tick; a timer never fires before its deadline. With
+// 10 ms ticks the wheel spans ~22 years, and later deadlines are parked in
+// the farthest slot and re-placed when it comes up. Not thread-safe.
+#define TIMER_WHEEL_LEVELS 6
+#define TIMER_WHEEL_SLOT_BITS 6
+#define TIMER_WHEEL_SLOTS (1u << TIMER_WHEEL_SLOT_BITS)
+
+struct wheel_link {
+  struct wheel_link *prev;
+  struct wheel_link *next;
+};
+
+typedef struct wheel_link WheelLink;
+
+struct wheel_timer;
+
+typedef void (*wheel_callback_fn)(struct wheel_timer *timer);
+
+// Embedded in whatever owns the schedule (a domain, a retry, a probe). Zero
+// it, set `callback` and `ctx`, then schedule it as often as needed. The
+// callback runs from timer_wheel_advance() and may schedule or cancel any
+// timer, itself included.
+struct wheel_timer {
+  WheelLink link;          // first: a link is cast back to its timer
+  uint64_t expires;        // tick
+  int bucket;              // level * TIMER_WHEEL_SLOTS + slot, -1 = not in the wheel
+  bool pending;
+  wheel_callback_fn callback;
+  void *ctx;
+};
+
+typedef struct wheel_timer WheelTimer;
+
+struct timer_wheel {
+  uint64_t origin_ns;
+  uint64_t tick_ns;
+  uint64_t current;        // last tick processed
+  size_t count;
+  uint64_t occupied[TIMER_WHEEL_LEVELS];
+  WheelLink slots[TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS];
+};
+
+typedef struct timer_wheel TimerWheel;
+
+void timer_wheel_init(TimerWheel *wheel, uint64_t tick_ns, uint64_t now_ns);
+
+// (Re)schedules `timer` for `deadline_ns`; a pending timer is moved. A
+// deadline already past fires on the next tick.
+void timer_wheel_schedule(TimerWheel *wheel, WheelTimer *timer, uint64_t deadline_ns);
+
+// No-op if the timer is not pending.
+void timer_wheel_cancel(TimerWheel *wheel, WheelTimer *timer);
+
+// Fires every timer due at `now_ns`, in deadline order across slots. Returns
+// how many fired.
+size_t timer_wheel_advance(TimerWheel *wheel, uint64_t now_ns);
+
+// When the next timer is due (possibly a cascade point a little earlier),
+// or 0 when the wheel is empty.
+uint64_t timer_wheel_next_ns(const TimerWheel *wheel);
+
+static inline size_t timer_wheel_count(const TimerWheel *wheel) { return wheel->count; }
@@ -0,0 +1,92 @@
+#include "trigger_scheduler.h"
+
+static const char *SOURCE_NAMES[TRIGGER_SOURCE_COUNT] = {
+    [TRIGGER_INTERVAL] = "interval",
+    [TRIGGER_NETLINK] = "netlink",
+    [TRIGGER_CONTROL] = "control",
+    [TRIGGER_RELOAD] = "reload",
+};
+
+const char *trigger_source_name(trigger_source_t source) { return SOURCE_NAMES[source]; }
+
+void trigger_init(TriggerScheduler *ts, uint64_t debounce_ns, uint64_t max_delay_ns) {
+  *ts = (TriggerScheduler) { .debounce_ns = debounce_ns, .max_delay_ns = max_delay_ns };
+}
+
+uint64_t trigger_request(TriggerScheduler *ts, trigger_source_t source, uint64_t delay_ns, uint64_t now_ns) {
+  if (ts->running) {
+    if (source == TRIGGER_INTERVAL) {
+      ts->coalesced++;
+      return 0;
+    }
+
+    if (ts->follow_up) ts->coalesced++;
+
+    ts->follow_up = true;
+    ts->pending |= 1u << source;
+
+    return 0;
+  }
+
+  uint64_t due = now_ns + delay_ns;
+  if (ts->last_end_ns && due < ts->last_end_ns + ts->debounce_ns) due = ts->last_end_ns + ts->debounce_ns;
+
+  if (ts->first_ns == 0) {
+    ts->first_ns = now_ns;
+    ts->due_ns = due;
+    ts->pending = 1u << source;
+    ts->merged = 1;
+
+    return ts->due_ns;
+  }
+
+  ts->pending |= 1u << source;
+  ts->merged++;
+  ts->coalesced++;
+
+  uint64_t next;
+
+  if (delay_ns == 0) {
+    // An immediate request must not wait out another source's settle delay
+    // or jitter; `due` already respects the debounce.
+    next = MIN(ts->due_ns, due);
+  } else {
+    uint64_t limit = ts->first_ns + ts->max_delay_ns;
+    next = MIN(MAX(ts->due_ns, due), MAX(limit, ts->due_ns));
+  }
+
+  if (next == ts->due_ns) return 0;
+
+  ts->due_ns = next;
+
+  return ts->due_ns;
+}
+
+bool trigger_begin_cycle(TriggerScheduler *ts, uint64_t now_ns, unsigned int *sources, unsigned int *merged) {
+  if (ts->running || ts->first_ns == 0 || now_ns < ts->due_ns) return false;
+
+  *sources = ts->pending;
+  *merged = ts->merged;
+
+  ts->running = true;
+  ts->first_ns = 0;
+  ts->pending = 0;
+  ts->merged = 0;
+
+  return true;
+}
+
+uint64_t trigger_end_cycle(TriggerScheduler *ts, uint64_t now_ns) {
+  ts->running = false;
+  ts->last_end_ns = now_ns;
+
+  if (!ts->follow_up) return 0;
+
+  // Sources recorded while running become the next pending cycle.
+  ts->follow_up = false;
+  ts->first_ns = now_ns;
+  ts->due_ns = now_ns + ts->debounce_ns;
+  ts->merged = 1;
+
+  return ts->due_ns;
+}
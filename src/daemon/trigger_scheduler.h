@@ -0,0 +1,52 @@
+#pragma once
+
+#include "../common.h"
+
+typedef enum {
+  TRIGGER_INTERVAL,
+  TRIGGER_NETLINK,   // address change reported by the kernel
+  TRIGGER_CONTROL,   // trigger-now on the control socket
+  TRIGGER_RELOAD,    // reload that added domains
+  TRIGGER_SOURCE_COUNT
+} trigger_source_t;
+
+// Merges bursts of triggers into single cycles. Times are CLOCK_MONOTONIC
+// nanoseconds; the caller owns the timer and arms it at whatever due time
+// the scheduler returns. Loop thread only.
+//
+// - A trigger becomes due after its own delay, but never sooner than
+//   `debounce_ns` after the previous cycle ended.
+// - Further triggers before that join the pending cycle and may push it back,
+//   but never past `max_delay_ns` after the first one (no starvation). An
+//   immediate one (zero delay) instead pulls it forward to its own due time.
+// - Triggers while a cycle runs queue at most one follow-up; interval ticks
+//   during a cycle are dropped since that cycle already covers them.
+struct trigger_scheduler {
+  uint64_t debounce_ns;
+  uint64_t max_delay_ns;
+  uint64_t first_ns;      // first pending trigger, 0 = none pending
+  uint64_t due_ns;
+  uint64_t last_end_ns;
+  unsigned int pending;   // bitmask of trigger_source_t
+  unsigned int merged;    // requests folded into the pending cycle
+  bool running;
+  bool follow_up;
+  uint64_t coalesced;     // lifetime count of requests that did not get their own cycle
+};
+
+typedef struct trigger_scheduler TriggerScheduler;
+
+void trigger_init(TriggerScheduler *ts, uint64_t debounce_ns, uint64_t max_delay_ns);
+
+// Returns the time to (re)arm the timer for, or 0 when nothing changed.
+uint64_t trigger_request(TriggerScheduler *ts, trigger_source_t source, uint64_t delay_ns, uint64_t now_ns);
+
+// Call when the timer fires. Returns false if the cycle is not due yet
+// (stale timer); otherwise hands over the pending sources and marks the
+// cycle as running.
+bool trigger_begin_cycle(TriggerScheduler *ts, uint64_t now_ns, unsigned int *sources, unsigned int *merged);
+
+// Returns when to arm the timer for the follow-up cycle, or 0 if none.
+uint64_t trigger_end_cycle(TriggerScheduler *ts, uint64_t now_ns);
+
+const char *trigger_source_name(trigger_source_t source);
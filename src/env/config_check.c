@@ -0,0 +1,259 @@
+#include "config_check.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include "../daemon/cycle_budget.h"
+#include "../faults/fault_injection.h"
+#include "../tracing/probes.h"
+#include "../utils/time_utils.h"
+
+typedef enum {
+  REMOTE_TOKEN,
+  REMOTE_ZONE,
+  REMOTE_PROVIDER,
+} remote_kind_t;
+
+struct remote_task {
+  remote_kind_t kind;
+  size_t index;  // into the IP provider list, for REMOTE_PROVIDER
+  const char *subject;
+  CheckResult *result;
+};
+
+typedef struct remote_task RemoteTask;
+
+struct remote_batch {
+  RemoteTask *tasks;
+  size_t length;
+  atomic_size_t next;
+  const char *token;
+  const RemoteCheckHooks *hooks;
+};
+
+typedef struct remote_batch RemoteBatch;
+
+static const char *STATUS_DETAILS[] = {
+    [SETTING_STATUS_OK] = "",
+    [SETTING_STATUS_DEFAULTED] = "unset, using default",
+    [SETTING_STATUS_MISSING] = "required but unset",
+    [SETTING_STATUS_INVALID] = "invalid value",
+};
+
+static void run_format_checks(Env *env, ValidationReport *report) {
+  for (setting_id_t id = 0; id < SETTING_COUNT; id++) {
+    CheckResult *result = report_reserve(report, "format", env_setting_name(id));
+    uint64_t start = monotonic_ns();
+
+    setting_status_t status = env_check(env, id);
+
+    result->duration_ns = monotonic_ns() - start;
+    result->status = status == SETTING_STATUS_MISSING || status == SETTING_STATUS_INVALID ? CHECK_FAILED : CHECK_PASSED;
+    snprintf(result->detail, sizeof(result->detail), "%s", STATUS_DETAILS[status]);
+  }
+}
+
+// TCP reachability of host[/path] on 443 within REMOTE_CHECK_TIMEOUT_MS.
+// `provider` is the URL's index in IP_V4_APIS, as in the metrics.
+static bool probe_provider(size_t provider, const char *url, char *detail, size_t detail_size) {
+  uint64_t start = monotonic_ns();
+  PROBE_PROVIDER_START(provider, url);
+
+  char host[MAX_URL_LENGTH + 1];
+  size_t host_len = MIN(strcspn(url, "/"), MAX_URL_LENGTH);
+  memcpy(host, url, host_len);
+  host[host_len] = '\0';
+
+  struct addrinfo hints = { .ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM };
+  struct addrinfo *res = NULL;
+
+  BudgetSpan resolve = budget_span_begin(TRACE_DNS_RESOLVE);
+  int rc = getaddrinfo(host, HTTPS_PORT, &hints, &res);
+  budget_span_end(&resolve, url);
+
+  if (rc != 0) {
+    snprintf(detail, detail_size, "resolve: %s", gai_strerror(rc));
+    PROBE_PROVIDER_END(provider, monotonic_ns() - start, false);
+    return false;
+  }
+
+  bool ok = false;
+  int err = ETIMEDOUT;
+
+  for (struct addrinfo *ai = res; ai && !ok; ai = ai->ai_next) {
+    fault_t fault = fault_inject(FAULT_SITE_SOCKET);
+
+    if (fault != FAULT_NONE) {
+      err = fault == FAULT_RESET ? ECONNRESET : ETIMEDOUT;
+      continue;
+    }
+
+    int fd = socket(ai->ai_family, ai->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, ai->ai_protocol);
+    if (fd < 0) continue;
+
+    BudgetSpan attempt = budget_span_begin(TRACE_CONNECT);
+
+    if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+      ok = true;
+    } else if (errno == EINPROGRESS) {
+      struct pollfd pfd = { .fd = fd, .events = POLLOUT };
+      socklen_t len = sizeof(err);
+
+      if (poll(&pfd, 1, REMOTE_CHECK_TIMEOUT_MS) == 1 && getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) == 0) {
+        ok = err == 0;
+      }
+    } else {
+      err = errno;
+    }
+
+    budget_span_end(&attempt, url);
+    close(fd);
+  }
+
+  freeaddrinfo(res);
+
+  if (!ok) snprintf(detail, detail_size, "connect: %s", strerror(err));
+
+  PROBE_PROVIDER_END(provider, monotonic_ns() - start, ok);
+
+  return ok;
+}
+
+static void run_remote_task(const RemoteBatch *batch, RemoteTask *task) {
+  CheckResult *result = task->result;
+  uint64_t start = monotonic_ns();
+  bool ok = false;
+
+  // Hook failures are reported through the result, not the worker's flags.
+  ErrorContext ctx;
+  error_scope_begin(&ctx);
+
+  switch (task->kind) {
+    case REMOTE_TOKEN:
+      if (!batch->hooks || !batch->hooks->verify_token) goto done;
+      ok = batch->hooks->verify_token(batch->token, result->detail, sizeof(result->detail));
+      break;
+
+    case REMOTE_ZONE:
+      if (!batch->hooks || !batch->hooks->zone_exists) goto done;
+      ok = batch->hooks->zone_exists(batch->token, task->subject, result->detail, sizeof(result->detail));
+      break;
+
+    default:
+      ok = probe_provider(task->index, task->subject, result->detail, sizeof(result->detail));
+      break;
+  }
+
+  result->duration_ns = monotonic_ns() - start;
+  result->status = ok ? CHECK_PASSED : CHECK_FAILED;
+
+done:
+  error_scope_end(&ctx);
+}
+
+static void *remote_worker(void *arg) {
+  RemoteBatch *batch = arg;
+
+  for (;;) {
+    size_t idx = atomic_fetch_add_explicit(&batch->next, 1, memory_order_relaxed);
+    if (idx >= batch->length) break;
+
+    run_remote_task(batch, &batch->tasks[idx]);
+  }
+
+  return NULL;
+}
+
+static void add_task(RemoteBatch *batch, ValidationReport *report, remote_kind_t kind, size_t index, const char *name,
+                     const char *subject, bool inputs_valid) {
+  CheckResult *result = report_reserve(report, name, subject);
+  if (!result) return;
+
+  if (!inputs_valid) {
+    snprintf(result->detail, sizeof(result->detail), "skipped: invalid input");
+    return;
+  }
+
+  snprintf(result->detail, sizeof(result->detail), "skipped: no API client");
+  batch->tasks[batch->length++] = (RemoteTask) { .kind = kind, .index = index, .subject = subject, .result = result };
+}
+
+static void run_remote_checks(Env *env, const ValidationOptions *options, ValidationReport *report) {
+  bool token_ok = env->status[SETTING_CLOUDFLARE_API_KEY] == SETTING_STATUS_OK;
+  bool domains_ok = env->status[SETTING_DOMAINS] == SETTING_STATUS_OK;
+  MetaArray domains = env_domains(env);
+  MetaArray providers = env_ip_v4_apis(env);
+
+  RemoteBatch batch = {
+      .tasks = mm_calloc(1 + domains.length + providers.length, sizeof(RemoteTask)),
+      .length = 0,
+      .token = env_cloudflare_api_key(env),
+      .hooks = options->hooks,
+  };
+  atomic_init(&batch.next, 0);
+
+  if (!batch.tasks) return;
+
+  add_task(&batch, report, REMOTE_TOKEN, 0, "token", CLOUDFLARE_API_KEY_ENV_VAR, token_ok);
+
+  for (size_t i = 0; i < domains.length; i++) {
+    add_task(&batch, report, REMOTE_ZONE, i, "zone", ((char **) domains.data)[i], token_ok && domains_ok);
+  }
+
+  for (size_t i = 0; i < providers.length; i++) {
+    add_task(&batch, report, REMOTE_PROVIDER, i, "provider", ((char **) providers.data)[i], true);
+  }
+
+  size_t threads = options->threads ? options->threads : REMOTE_CHECK_MAX_THREADS;
+  threads = MIN(threads, batch.length);
+
+  pthread_t workers[REMOTE_CHECK_MAX_THREADS];
+  size_t started = 0;
+
+  // The calling thread is one of the workers, so the batch finishes even if
+  // no extra thread could be started.
+  while (started + 1 < MIN(threads, (size_t) REMOTE_CHECK_MAX_THREADS) &&
+         pthread_create(&workers[started], NULL, remote_worker, &batch) == 0) {
+    started++;
+  }
+
+  remote_worker(&batch);
+
+  for (size_t i = 0; i < started; i++) pthread_join(workers[i], NULL);
+
+  mm_free(batch.tasks);
+}
+
+bool validate_configuration(Env *env, const ValidationOptions *options, ValidationReport *report) {
+  uint64_t start = monotonic_ns();
+  ValidationOptions defaults = { .remote = false, .threads = 0, .hooks = NULL };
+  if (!options) options = &defaults;
+
+  if (!report_init(report, SETTING_COUNT)) return false;
+
+  run_format_checks(env, report);
+  size_t format_checks = report->length;
+
+  // Sized only now so the format pass above is what first resolves (and
+  // times) every setting.
+  if (options->remote && report_grow(report, 1 + env_domains(env).length + env_ip_v4_apis(env).length)) {
+    run_remote_checks(env, options, report);
+  }
+
+  report_finish(report, monotonic_ns() - start);
+
+  for (size_t i = format_checks; i < report->length; i++) {
+    if (report->items[i].status == CHECK_FAILED) {
+      error_set(ERR_REMOTE_CHECK);
+      break;
+    }
+  }
+
+  return report->failed == 0;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "../common.h"
+#include "../errors/errors.h"
+#include "../errors/error_reporter.h"
+#include "env.h"
+
+// Checks that need the Cloudflare API. Each returns true on success and may
+// explain a failure in `detail`. A NULL hook is reported as skipped.
+struct remote_check_hooks {
+  bool (*verify_token)(const char *token, char *detail, size_t detail_size);
+  bool (*zone_exists)(const char *token, const char *domain, char *detail, size_t detail_size);
+};
+
+typedef struct remote_check_hooks RemoteCheckHooks;
+
+struct validation_options {
+  bool remote;           // also run the network checks
+  unsigned int threads;  // 0 = REMOTE_CHECK_MAX_THREADS
+  const RemoteCheckHooks *hooks;
+};
+
+typedef struct validation_options ValidationOptions;
+
+// Format-checks every setting in one pass (no fail-fast), then optionally
+// runs token verification, per-domain zone lookups and IP provider
+// reachability concurrently. Every finding, with its timing, lands in
+// `report` (initialized here; release with report_free()). Returns true when
+// nothing failed; otherwise ERR_INVALID_ENV and/or ERR_REMOTE_CHECK are set.
+bool validate_configuration(Env *env, const ValidationOptions *options, ValidationReport *report);
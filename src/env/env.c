@@ -0,0 +1,280 @@
+#include "env.h"
+
+#include <sched.h>
+
+#include "env_validator.h"
+#include "secret.h"
+#include "../tracing/trace.h"
+#include "parsers/url_parser.h"
+#include "parsers/value_parser.h"
+
+enum slot_state {
+  SLOT_UNPARSED,
+  SLOT_PARSING,
+  SLOT_READY,
+};
+
+struct setting_descriptor {
+  const char *env_var;
+  const char *default_raw;  // NULL = required
+  const char *(*load)(Env *env);  // NULL = env->lookup(env_var)
+  bool (*parse)(const char *raw, SettingValue *out);
+  bool (*validate)(const SettingValue *value);
+  bool owns_list;
+  CombinedErrorCode error;
+};
+
+typedef struct setting_descriptor SettingDescriptor;
+
+static int compare_strings(const void *a, const void *b) {
+  return strcmp(*(char *const *) a, *(char *const *) b);
+}
+
+static void sort_unique(MetaArray *list) {
+  char **items = list->data;
+  if (!items || list->length < 2) return;
+
+  qsort(items, list->length, sizeof(char *), compare_strings);
+
+  size_t unique = 1;
+
+  for (size_t i = 1; i < list->length; i++) {
+    if (strcmp(items[i], items[unique - 1]) != 0) items[unique++] = items[i];
+  }
+
+  list->length = unique;
+}
+
+static bool parse_string(const char *raw, SettingValue *out) {
+  out->string = raw;
+  return true;
+}
+
+// The token never goes through the generic raw lookup: it is moved into the
+// locked secret page and the variable it came from (if any) is wiped.
+static const char *load_api_key(Env *env) {
+  return secret_load_api_key(&env->secret, env->lookup, env->source);
+}
+
+static bool parse_list(const char *raw, SettingValue *out) {
+  out->list = parse_urls(raw);
+  return out->list.data != NULL;
+}
+
+static bool parse_domain_list(const char *raw, SettingValue *out) {
+  if (!parse_list(raw, out)) return false;
+
+  sort_unique(&out->list);
+
+  return true;
+}
+
+static bool parse_boolean(const char *raw, SettingValue *out) { return parse_bool(raw, &out->boolean); }
+
+static bool parse_number(const char *raw, SettingValue *out) { return parse_uint(raw, &out->number); }
+
+static bool parse_level(const char *raw, SettingValue *out) {
+  log_level_t level;
+  if (!parse_log_level(raw, &level)) return false;
+
+  out->number = level;
+
+  return true;
+}
+
+static bool validate_api_key(const SettingValue *v) { return is_valid_cloudflare_api_key(v->string); }
+
+static bool validate_domains(const SettingValue *v) { return is_valid_domain_list(&v->list); }
+
+static bool validate_urls(const SettingValue *v) { return is_valid_url_list(&v->list); }
+
+static bool validate_minutes(const SettingValue *v) { return is_valid_minutes_between_updates(v->number); }
+
+static bool validate_delay(const SettingValue *v) { return is_valid_propagation_delay_seconds(v->number); }
+
+static bool validate_budget(const SettingValue *v) { return is_valid_cycle_budget_seconds(v->number); }
+
+static bool validate_state_max_age(const SettingValue *v) { return is_valid_state_max_age_minutes(v->number); }
+
+static bool validate_socket_path(const SettingValue *v) { return is_valid_socket_path(v->string); }
+
+static bool validate_group_dir(const SettingValue *v) { return is_valid_group_dir(v->string); }
+
+static bool validate_snapshot_path(const SettingValue *v) { return is_valid_snapshot_path(v->string); }
+
+static bool validate_listen(const SettingValue *v) { return is_valid_listen_address(v->string); }
+
+static const SettingDescriptor REGISTRY[SETTING_COUNT] = {
+    [SETTING_CLOUDFLARE_API_KEY] = {
+        CLOUDFLARE_API_KEY_ENV_VAR, NULL, load_api_key,
+        parse_string, validate_api_key, false, ERR_INVALID_ENV_CLOUDFLARE_KEY },
+    [SETTING_DOMAINS] = {
+        DOMAINS_ENV_VAR, NULL, NULL,
+        parse_domain_list, validate_domains, true, ERR_INVALID_ENV_DOMAINS },
+    [SETTING_PROXIED] = {
+        PROXIED_ENV_VAR, DEFAULT_PROXIED, NULL,
+        parse_boolean, NULL, false, ERR_INVALID_ENV_PROXIED },
+    [SETTING_MINUTES_BETWEEN_UPDATES] = {
+        MINUTES_BETWEEN_UPDATES_ENV_VAR, STRINGIFY(DEFAULT_MINUTES_BETWEEN_UPDATES), NULL,
+        parse_number, validate_minutes, false, ERR_INVALID_ENV_MINUTES_BETWEEN_UPDATES },
+    [SETTING_PROPAGATION_DELAY_SECONDS] = {
+        PROPAGATION_DELAY_SECONDS_ENV_VAR, STRINGIFY(DEFAULT_PROPAGATION_DELAY_SECONDS), NULL,
+        parse_number, validate_delay, false, ERR_INVALID_ENV_PROPAGATION_DELAY_SECONDS },
+    [SETTING_IP_V4_APIS] = {
+        IP_V4_APIS_ENV_VAR, DEFAULT_IP_V4_APIS, NULL,
+        parse_list, validate_urls, true, ERR_INVALID_ENV_IP_V4_APIS },
+    [SETTING_LOG_LEVEL] = {
+        LOG_LEVEL_ENV_VAR, DEFAULT_LOG_LEVEL, NULL,
+        parse_level, NULL, false, ERR_INVALID_ENV_LOG_LEVEL },
+    [SETTING_METRICS_LISTEN] = {
+        METRICS_LISTEN_ENV_VAR, DEFAULT_METRICS_LISTEN, NULL,
+        parse_string, validate_listen, false, ERR_INVALID_ENV_METRICS_LISTEN },
+    [SETTING_CYCLE_BUDGET_SECONDS] = {
+        CYCLE_BUDGET_SECONDS_ENV_VAR, STRINGIFY(DEFAULT_CYCLE_BUDGET_SECONDS), NULL,
+        parse_number, validate_budget, false, ERR_INVALID_ENV_CYCLE_BUDGET },
+    [SETTING_CONTROL_SOCKET] = {
+        CONTROL_SOCKET_ENV_VAR, DEFAULT_CONTROL_SOCKET, NULL,
+        parse_string, validate_socket_path, false, ERR_INVALID_ENV_CONTROL_SOCKET },
+    [SETTING_DETECTION_GROUP_DIR] = {
+        DETECTION_GROUP_DIR_ENV_VAR, DEFAULT_DETECTION_GROUP_DIR, NULL,
+        parse_string, validate_group_dir, false, ERR_INVALID_ENV_DETECTION_GROUP },
+    [SETTING_IP_SNAPSHOT_PATH] = {
+        IP_SNAPSHOT_PATH_ENV_VAR, DEFAULT_IP_SNAPSHOT_PATH, NULL,
+        parse_string, validate_snapshot_path, false, ERR_INVALID_ENV_IP_SNAPSHOT },
+    [SETTING_STATE_MAX_AGE_MINUTES] = {
+        STATE_MAX_AGE_MINUTES_ENV_VAR, STRINGIFY(DEFAULT_STATE_MAX_AGE_MINUTES), NULL,
+        parse_number, validate_state_max_age, false, ERR_INVALID_ENV_STATE_MAX_AGE },
+};
+
+static const char *lookup_process_env(const void *source, const char *key) {
+  (void) source;
+  return getenv(key);
+}
+
+void env_init(Env *env, env_lookup_fn lookup, const void *source) {
+  env->lookup = lookup ? lookup : lookup_process_env;
+  env->source = source;
+
+  for (size_t i = 0; i < SETTING_COUNT; i++) {
+    atomic_init(&env->state[i], SLOT_UNPARSED);
+    memset(&env->values[i], 0, sizeof(SettingValue));
+    env->status[i] = SETTING_STATUS_OK;
+  }
+
+  env->secret = (Secret) { .page = NULL };
+}
+
+void env_cleanup(Env *env) {
+  for (size_t i = 0; i < SETTING_COUNT; i++) {
+    if (REGISTRY[i].owns_list && atomic_load(&env->state[i]) == SLOT_READY) mm_free(env->values[i].list.data);
+
+    atomic_store(&env->state[i], SLOT_UNPARSED);
+    memset(&env->values[i], 0, sizeof(SettingValue));
+  }
+
+  secret_wipe(&env->secret);
+}
+
+const char *env_raw(const Env *env, setting_id_t id) {
+  return env->lookup(env->source, REGISTRY[id].env_var);
+}
+
+const char *env_setting_name(setting_id_t id) {
+  return REGISTRY[id].env_var;
+}
+
+static void release_value(const SettingDescriptor *desc, SettingValue *value) {
+  if (desc->owns_list) mm_free(value->list.data);
+  memset(value, 0, sizeof(SettingValue));
+}
+
+static bool parse_and_validate(const SettingDescriptor *desc, const char *raw, SettingValue *out) {
+  if (!raw || !desc->parse(raw, out)) return false;
+
+  if (desc->validate && !desc->validate(out)) {
+    release_value(desc, out);
+    return false;
+  }
+
+  return true;
+}
+
+static void resolve(Env *env, setting_id_t id) {
+  TRACE_BEGIN(span, TRACE_ENV_PARSE);
+
+  const SettingDescriptor *desc = &REGISTRY[id];
+  SettingValue value;
+  memset(&value, 0, sizeof(value));
+
+  const char *raw = desc->load ? desc->load(env) : env_raw(env, id);
+  setting_status_t status = SETTING_STATUS_OK;
+
+  if (!parse_and_validate(desc, raw, &value)) {
+    // Unset optional settings silently take their default; anything else
+    // that fails is reported and still falls back to the default.
+    if (raw) {
+      status = SETTING_STATUS_INVALID;
+    } else {
+      status = desc->default_raw ? SETTING_STATUS_DEFAULTED : SETTING_STATUS_MISSING;
+    }
+
+    if (status != SETTING_STATUS_DEFAULTED) {
+      error_set(desc->error);
+      error_set(ERR_INVALID_ENV);
+    }
+
+    if (desc->default_raw) parse_and_validate(desc, desc->default_raw, &value);
+  }
+
+  env->values[id] = value;
+  env->status[id] = status;
+
+  TRACE_END(span);
+}
+
+static const SettingValue *get(Env *env, setting_id_t id) {
+  unsigned char expected = SLOT_UNPARSED;
+
+  if (atomic_load_explicit(&env->state[id], memory_order_acquire) == SLOT_READY) return &env->values[id];
+
+  if (atomic_compare_exchange_strong(&env->state[id], &expected, SLOT_PARSING)) {
+    resolve(env, id);
+    atomic_store_explicit(&env->state[id], SLOT_READY, memory_order_release);
+  } else {
+    while (atomic_load_explicit(&env->state[id], memory_order_acquire) != SLOT_READY) sched_yield();
+  }
+
+  return &env->values[id];
+}
+
+setting_status_t env_check(Env *env, setting_id_t id) {
+  get(env, id);
+
+  return env->status[id];
+}
+
+const char *env_cloudflare_api_key(Env *env) { return get(env, SETTING_CLOUDFLARE_API_KEY)->string; }
+
+MetaArray env_domains(Env *env) { return get(env, SETTING_DOMAINS)->list; }
+
+bool env_proxied(Env *env) { return get(env, SETTING_PROXIED)->boolean; }
+
+unsigned int env_minutes_between_updates(Env *env) { return get(env, SETTING_MINUTES_BETWEEN_UPDATES)->number; }
+
+unsigned int env_propagation_delay_seconds(Env *env) { return get(env, SETTING_PROPAGATION_DELAY_SECONDS)->number; }
+
+MetaArray env_ip_v4_apis(Env *env) { return get(env, SETTING_IP_V4_APIS)->list; }
+
+log_level_t env_log_level(Env *env) { return (log_level_t) get(env, SETTING_LOG_LEVEL)->number; }
+
+const char *env_metrics_listen(Env *env) { return get(env, SETTING_METRICS_LISTEN)->string; }
+
+unsigned int env_cycle_budget_seconds(Env *env) { return get(env, SETTING_CYCLE_BUDGET_SECONDS)->number; }
+
+const char *env_control_socket(Env *env) { return get(env, SETTING_CONTROL_SOCKET)->string; }
+
+const char *env_detection_group_dir(Env *env) { return get(env, SETTING_DETECTION_GROUP_DIR)->string; }
+
+const char *env_ip_snapshot_path(Env *env) { return get(env, SETTING_IP_SNAPSHOT_PATH)->string; }
+
+unsigned int env_state_max_age_minutes(Env *env) { return get(env, SETTING_STATE_MAX_AGE_MINUTES)->number; }
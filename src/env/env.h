@@ -0,0 +1,106 @@
+#pragma once
+
+#include <stdatomic.h>
+
+#include "../common.h"
+#include "../errors/errors.h"
+#include "../memory/memory_management.h"
+#include "../utils/meta_array.h"
+#include "secret.h"
+#include "tokens/config_tokens.h"
+
+// Every setting the client understands. Values are parsed and validated on
+// first access and memoized, so a run that never reaches a phase never pays
+// for the settings only that phase uses.
+typedef enum {
+  SETTING_CLOUDFLARE_API_KEY,
+  SETTING_DOMAINS,
+  SETTING_PROXIED,
+  SETTING_MINUTES_BETWEEN_UPDATES,
+  SETTING_PROPAGATION_DELAY_SECONDS,
+  SETTING_IP_V4_APIS,
+  SETTING_LOG_LEVEL,
+  SETTING_METRICS_LISTEN,
+  SETTING_CYCLE_BUDGET_SECONDS,
+  SETTING_CONTROL_SOCKET,
+  SETTING_DETECTION_GROUP_DIR,
+  SETTING_IP_SNAPSHOT_PATH,
+  SETTING_STATE_MAX_AGE_MINUTES,
+  SETTING_COUNT
+} setting_id_t;
+
+union setting_value {
+  const char *string;
+  bool boolean;
+  unsigned int number;
+  MetaArray list;
+};
+
+typedef union setting_value SettingValue;
+
+typedef enum {
+  SETTING_STATUS_OK,
+  SETTING_STATUS_DEFAULTED,  // unset, default used
+  SETTING_STATUS_MISSING,    // unset and required
+  SETTING_STATUS_INVALID,    // set but unparsable or out of range
+} setting_status_t;
+
+// Where raw values come from: the process environment, an env file...
+typedef const char *(*env_lookup_fn)(const void *source, const char *key);
+
+struct env {
+  env_lookup_fn lookup;
+  const void *source;
+  atomic_uchar state[SETTING_COUNT];
+  SettingValue values[SETTING_COUNT];
+  setting_status_t status[SETTING_COUNT];
+  Secret secret;  // backs the CLOUDFLARE_API_KEY value
+};
+
+typedef struct env Env;
+
+// `lookup` NULL reads the process environment.
+void env_init(Env *env, env_lookup_fn lookup, const void *source);
+
+void env_cleanup(Env *env);
+
+// Raw, unparsed value (NULL when unset). Never memoized.
+const char *env_raw(const Env *env, setting_id_t id);
+
+const char *env_setting_name(setting_id_t id);
+
+// Resolves the setting (if not done yet) and reports how it went.
+setting_status_t env_check(Env *env, setting_id_t id);
+
+// Typed accessors. An invalid value sets its ERR_INVALID_ENV_* flag plus
+// ERR_INVALID_ENV and yields the default (empty for required settings).
+const char *env_cloudflare_api_key(Env *env);
+
+MetaArray env_domains(Env *env);
+
+bool env_proxied(Env *env);
+
+unsigned int env_minutes_between_updates(Env *env);
+
+unsigned int env_propagation_delay_seconds(Env *env);
+
+MetaArray env_ip_v4_apis(Env *env);
+
+log_level_t env_log_level(Env *env);
+
+// "" when the metrics endpoint is disabled.
+const char *env_metrics_listen(Env *env);
+
+unsigned int env_cycle_budget_seconds(Env *env);
+
+// "" when the control socket is disabled.
+const char *env_control_socket(Env *env);
+
+// "" when this instance detects its IP on its own.
+const char *env_detection_group_dir(Env *env);
+
+// "" when no shared-memory IP snapshot is published.
+const char *env_ip_snapshot_path(Env *env);
+
+// 0 disables restoring the state file on startup.
+unsigned int env_state_max_age_minutes(Env *env);
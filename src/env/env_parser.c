@@ -0,0 +1,136 @@
+#include "env_parser.h"
+
+static char *read_whole_file(const char *path, size_t *len) {
+  FILE *fp = fopen(path, "rb");
+  if (!fp) return NULL;
+
+  char *buf = NULL;
+  long size = -1;
+
+  if (fseek(fp, 0, SEEK_END) == 0) size = ftell(fp);
+  if (size < 0 || fseek(fp, 0, SEEK_SET) != 0) goto done;
+
+  buf = mm_malloc((size_t) size + 1);
+  if (error_has(ERR_ALLOC_FAILURE)) goto done;
+
+  *len = fread(buf, 1, (size_t) size, fp);
+  buf[*len] = '\0';
+
+done:
+  fclose(fp);
+  return buf;
+}
+
+static size_t count_lines(const char *buf) {
+  size_t count = 1;
+
+  for (const char *c = buf; *c; c++) {
+    if (*c == '\n') count++;
+  }
+
+  return count;
+}
+
+static char *trim(char *start, char *end) {
+  while (start < end && isspace((unsigned char) *start)) start++;
+  while (end > start && isspace((unsigned char) end[-1])) end--;
+
+  *end = '\0';
+
+  return start;
+}
+
+static char *unquote(char *value) {
+  size_t len = strlen(value);
+
+  if (len >= 2 && (value[0] == '"' || value[0] == '\'') && value[len - 1] == value[0]) {
+    value[len - 1] = '\0';
+    return value + 1;
+  }
+
+  return value;
+}
+
+static bool parse_line(char *line, EnvEntry *entry) {
+  char *eq = strchr(line, '=');
+  if (!eq) return false;
+
+  char *key = trim(line, eq);
+  if (strncmp(key, "export ", 7) == 0) key = trim(key + 7, key + strlen(key));
+  if (*key == '\0' || *key == '#') return false;
+
+  char *value = trim(eq + 1, eq + 1 + strlen(eq + 1));
+
+  entry->key = key;
+  entry->value = unquote(value);
+
+  return true;
+}
+
+static size_t tokenize_lines(char *buf, EnvEntry *entries) {
+  size_t idx = 0;
+  char *start = buf;
+
+  for (char *c = buf; ; c++) {
+    if (*c == '\n' || *c == '\0') {
+      bool last = *c == '\0';
+      *c = '\0';
+
+      if (parse_line(start, &entries[idx])) idx++;
+
+      if (last) break;
+      start = c + 1;
+    }
+  }
+
+  return idx;
+}
+
+EnvFile parse_env_file(const char *path) {
+  EnvFile file = {
+      .buffer = NULL,
+      .entries = { .data = NULL, .length = 0 },
+  };
+
+  size_t len = 0;
+  file.buffer = path ? read_whole_file(path, &len) : NULL;
+
+  if (!file.buffer) {
+    error_set(ERR_INVALID_ENV_FILE);
+    return file;
+  }
+
+  EnvEntry *entries = mm_calloc(count_lines(file.buffer), sizeof(EnvEntry));
+  if (error_has(ERR_ALLOC_FAILURE)) {
+    env_file_free(&file);
+    return file;
+  }
+
+  file.entries.data = entries;
+  file.entries.length = tokenize_lines(file.buffer, entries);
+
+  return file;
+}
+
+const char *env_file_get(const EnvFile *file, const char *key) {
+  if (!file || !key) return NULL;
+
+  const EnvEntry *entries = file->entries.data;
+
+  for (size_t i = file->entries.length; i > 0; i--) {
+    if (strcmp(entries[i - 1].key, key) == 0) return entries[i - 1].value;
+  }
+
+  return NULL;
+}
+
+void env_file_free(EnvFile *file) {
+  if (!file) return;
+
+  mm_free(file->entries.data);
+  mm_free(file->buffer);
+
+  file->entries.data = NULL;
+  file->entries.length = 0;
+  file->buffer = NULL;
+}
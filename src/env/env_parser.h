@@ -2,3 +2,33 @@
 
 #include "../common.h"
 #include "../utils/array_utils.h"
+#include "../utils/meta_array.h"
+#include "../errors/errors.h"
+#include "../memory/memory_management.h"
+
+// KEY=VALUE pair pointing into the EnvFile buffer.
+struct env_entry {
+  const char *key;
+  const char *value;
+};
+
+typedef struct env_entry EnvEntry;
+
+// Parsed dotenv file. `entries` is a MetaArray of EnvEntry; every key and
+// value lives inside `buffer`, so the whole file is released with one free.
+struct env_file {
+  char *buffer;
+  MetaArray entries;
+};
+
+typedef struct env_file EnvFile;
+
+// Accepts blank lines, `#` comments, an optional `export ` prefix and values
+// wrapped in matching single or double quotes. Sets ERR_INVALID_ENV_FILE when
+// the file cannot be read.
+EnvFile parse_env_file(const char *path);
+
+// Later assignments win, like a shell sourcing the file.
+const char *env_file_get(const EnvFile *file, const char *key);
+
+void env_file_free(EnvFile *file);
@@ -0,0 +1,113 @@
+#include "env_validator.h"
+
+#include <arpa/inet.h>
+#include <sys/un.h>
+
+#include "parsers/value_parser.h"
+
+bool is_valid_cloudflare_api_key(const char *key) {
+  if (!key) return false;
+
+  size_t len = strlen(key);
+  if (len < MIN_CLOUDFLARE_API_KEY_LENGTH || len > MAX_CLOUDFLARE_API_KEY_LENGTH) return false;
+
+  for (const char *c = key; *c; c++) {
+    if (!isalnum((unsigned char) *c) && *c != '-' && *c != '_') return false;
+  }
+
+  return true;
+}
+
+bool is_valid_domain_list(const MetaArray *domains) {
+  if (!domains || domains->length == 0) return false;
+
+  char **names = domains->data;
+
+  for (size_t i = 0; i < domains->length; i++) {
+    if (!is_valid_hostname(names[i])) return false;
+  }
+
+  return true;
+}
+
+bool is_valid_url_list(const MetaArray *urls) {
+  if (!urls || urls->length == 0) return false;
+
+  char **items = urls->data;
+
+  for (size_t i = 0; i < urls->length; i++) {
+    char host[MAX_URL_LENGTH + 1];
+    size_t host_len = strcspn(items[i], "/");
+
+    if (host_len > MAX_URL_LENGTH) return false;
+
+    memcpy(host, items[i], host_len);
+    host[host_len] = '\0';
+
+    if (!is_valid_hostname(host)) return false;
+  }
+
+  return true;
+}
+
+bool is_valid_minutes_between_updates(unsigned int minutes) {
+  return minutes >= MIN_MINUTES_BETWEEN_UPDATES && minutes <= MAX_MINUTES_BETWEEN_UPDATES;
+}
+
+bool is_valid_propagation_delay_seconds(unsigned int seconds) {
+  return seconds <= MAX_PROPAGATION_DELAY_SECONDS;
+}
+
+bool is_valid_cycle_budget_seconds(unsigned int seconds) {
+  return seconds >= MIN_CYCLE_BUDGET_SECONDS && seconds <= MAX_CYCLE_BUDGET_SECONDS;
+}
+
+bool is_valid_state_max_age_minutes(unsigned int minutes) {
+  return minutes <= MAX_STATE_MAX_AGE_MINUTES;
+}
+
+bool is_valid_socket_path(const char *path) {
+  if (!path) return false;
+
+  return *path == '\0' || (path[0] == '/' && strlen(path) < sizeof(((struct sockaddr_un *) 0)->sun_path));
+}
+
+bool is_valid_group_dir(const char *path) {
+  if (!path) return false;
+
+  return *path == '\0' || (path[0] == '/' && strlen(path) + sizeof("/" DETECTION_GROUP_IP_FILE ".tmp.4294967295") <= MAX_STRING_LENGTH);
+}
+
+bool is_valid_snapshot_path(const char *path) {
+  if (!path) return false;
+
+  return *path == '\0' || (path[0] == '/' && strlen(path) < MAX_STRING_LENGTH);
+}
+
+bool is_valid_listen_address(const char *address) {
+  if (!address) return false;
+  if (*address == '\0') return true;
+
+  size_t prefix_len = strlen(METRICS_UNIX_PREFIX);
+
+  if (strncmp(address, METRICS_UNIX_PREFIX, prefix_len) == 0) {
+    const char *path = address + prefix_len;
+    return *path != '\0' && is_valid_socket_path(path);
+  }
+
+  const char *colon = strrchr(address, ':');
+  if (!colon || colon == address || colon - address > MAX_URL_LENGTH) return false;
+
+  unsigned int port;
+  if (!parse_uint(colon + 1, &port) || port == 0 || port > 65535) return false;
+
+  char host[MAX_URL_LENGTH + 1];
+  size_t host_len = (size_t) (colon - address);
+
+  memcpy(host, address, host_len);
+  host[host_len] = '\0';
+
+  struct in_addr ip;
+
+  return inet_pton(AF_INET, host, &ip) == 1 || is_valid_hostname(host);
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "../common.h"
+#include "../utils/meta_array.h"
+#include "../utils/validation.h"
+
+bool is_valid_cloudflare_api_key(const char *key);
+
+// Every entry must be a valid hostname; an empty list is invalid.
+bool is_valid_domain_list(const MetaArray *domains);
+
+// IP provider URLs: host[/path], no scheme.
+bool is_valid_url_list(const MetaArray *urls);
+
+bool is_valid_minutes_between_updates(unsigned int minutes);
+
+bool is_valid_propagation_delay_seconds(unsigned int seconds);
+
+bool is_valid_cycle_budget_seconds(unsigned int seconds);
+
+bool is_valid_state_max_age_minutes(unsigned int minutes);
+
+// "" (disabled) or an absolute path that fits in sun_path.
+bool is_valid_socket_path(const char *path);
+
+// "" (disabled) or an absolute path with room for the group's file names.
+bool is_valid_group_dir(const char *path);
+
+// "" (disabled) or an absolute path.
+bool is_valid_snapshot_path(const char *path);
+
+// "" (disabled), "unix:/absolute/path" or "host:port".
+bool is_valid_listen_address(const char *address);
@@ -20,18 +20,26 @@ static inline char *buffer_ptr(void *block, size_t tokens_count) { return (char
 static inline void init_buffer(char *buf, const char *src, size_t len) { memcpy(buf, src, len + 1); }
 
 
+// Tokens are trimmed in place, so "a.com, b.com" yields "a.com" and "b.com".
 static void tokenize_buffer(char *buf, char **tokens) {
   size_t idx = 0;
   char *start = buf;
 
   for (char *delim = buf; ; ++delim) {
-    if (*delim == DOMAIN_DELIMITER || *delim == '\0') {
+    bool last = *delim == '\0';
+
+    if (*delim == DOMAIN_DELIMITER || last) {
+      char *end = delim;
+      while (end > start && isspace((unsigned char) end[-1])) end--;
+      while (start < end && isspace((unsigned char) *start)) start++;
+
       *delim = '\0';
+      *end = '\0';
       tokens[idx++] = start;
       start = delim + 1;
     }
 
-    if (*delim == '\0') break;
+    if (last) break;
   }
 }
 
@@ -0,0 +1,53 @@
+#include "value_parser.h"
+
+#include <errno.h>
+#include <limits.h>
+
+static const ConfigToken *lookup(const char *str, token_kind_t kind) {
+  return str ? config_token_lookup(str, strlen(str), kind) : NULL;
+}
+
+bool parse_bool(const char *str, bool *out) {
+  const ConfigToken *token = lookup(str, TOKEN_KIND_BOOL);
+  if (!token) return false;
+
+  *out = token->value != 0;
+
+  return true;
+}
+
+bool parse_log_level(const char *str, log_level_t *out) {
+  const ConfigToken *token = lookup(str, TOKEN_KIND_LOG_LEVEL);
+  if (!token) return false;
+
+  *out = (log_level_t) token->value;
+
+  return true;
+}
+
+bool parse_provider_format(const char *str, provider_format_t *out) {
+  const ConfigToken *token = lookup(str, TOKEN_KIND_PROVIDER_FORMAT);
+  if (!token) return false;
+
+  *out = (provider_format_t) token->value;
+
+  return true;
+}
+
+bool parse_uint(const char *str, unsigned int *out) {
+  if (!str) return false;
+
+  size_t len;
+  const char *token = str_trim(str, &len);
+  if (len == 0 || !isdigit((unsigned char) *token)) return false;
+
+  char *end = NULL;
+  errno = 0;
+  unsigned long value = strtoul(token, &end, 10);
+
+  if (errno != 0 || end != token + len || value > UINT_MAX) return false;
+
+  *out = (unsigned int) value;
+
+  return true;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "../../common.h"
+#include "../../utils/string_utils.h"
+#include "../tokens/config_tokens.h"
+
+// Enumerated values go through the generated perfect-hash token table (see
+// tokens/config_tokens.def): case-insensitive, surrounding whitespace ignored.
+bool parse_bool(const char *str, bool *out);
+
+bool parse_log_level(const char *str, log_level_t *out);
+
+bool parse_provider_format(const char *str, provider_format_t *out);
+
+// Accepts a plain decimal number that fits in an unsigned int.
+bool parse_uint(const char *str, unsigned int *out);
@@ -0,0 +1,182 @@
+#include "secret.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+
+#define AUTH_HEADER_PREFIX "Authorization: Bearer "
+#define AUTH_HEADER_SUFFIX "\r\n"
+#define SECRET_PAGE_SIZE 4096
+
+// Token taken from a one-shot source, for the loads after a reload.
+// `fd` is the descriptor it was read from, -1 for the environment variable.
+static struct {
+  pthread_mutex_t lock;
+  char *page;
+  size_t length;
+  long fd;
+} consumed = { .lock = PTHREAD_MUTEX_INITIALIZER, .page = NULL, .length = 0, .fd = -1 };
+
+static char *map_locked_page(void) {
+  char *page = mmap(NULL, SECRET_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (page == MAP_FAILED) return NULL;
+
+  // Best effort: without CAP_IPC_LOCK or RLIMIT_MEMLOCK mlock may fail, the
+  // secret still stays out of core dumps and the environment.
+  mlock(page, SECRET_PAGE_SIZE);
+#ifdef MADV_DONTDUMP
+  madvise(page, SECRET_PAGE_SIZE, MADV_DONTDUMP);
+#endif
+
+  return page;
+}
+
+// Reads straight into the locked page; returns the token length or -1.
+static ssize_t read_token(int fd, char *dst, size_t capacity) {
+  size_t len = 0;
+
+  while (len < capacity) {
+    ssize_t n = read(fd, dst + len, capacity - len);
+
+    if (n < 0) return -1;
+    if (n == 0) break;
+
+    len += (size_t) n;
+  }
+
+  while (len > 0 && isspace((unsigned char) dst[len - 1])) len--;
+
+  return (ssize_t) len;
+}
+
+static ssize_t read_token_from_path(const char *path, char *dst, size_t capacity) {
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return -1;
+
+  ssize_t len = read_token(fd, dst, capacity);
+  close(fd);
+
+  return len;
+}
+
+static ssize_t copy_and_wipe(const char *value, char *dst, size_t capacity) {
+  size_t len = strlen(value);
+  if (len > capacity) return -1;
+
+  memcpy(dst, value, len);
+  explicit_bzero((char *) value, len);
+
+  return (ssize_t) len;
+}
+
+// A descriptor is drained and closed, and the environment variable wiped,
+// on first use. Later loads naming the same source get the kept copy.
+static ssize_t read_once(long fd, const char *value, char *dst, size_t capacity) {
+  ssize_t len;
+
+  pthread_mutex_lock(&consumed.lock);
+
+  if (consumed.page && consumed.fd == fd) {
+    len = consumed.length <= capacity ? (ssize_t) consumed.length : -1;
+    if (len > 0) memcpy(dst, consumed.page, (size_t) len);
+  } else {
+    len = fd >= 0 ? read_token((int) fd, dst, capacity) : copy_and_wipe(value, dst, capacity);
+    if (fd >= 0) close((int) fd);
+
+    if (len >= 0 && !consumed.page) consumed.page = map_locked_page();
+
+    if (len >= 0 && consumed.page) {
+      memcpy(consumed.page, dst, (size_t) len);
+      consumed.length = (size_t) len;
+      consumed.fd = fd;
+    }
+  }
+
+  pthread_mutex_unlock(&consumed.lock);
+
+  return len;
+}
+
+static ssize_t read_token_from_fd_var(const char *fd_str, char *dst, size_t capacity) {
+  char *end = NULL;
+  long fd = strtol(fd_str, &end, 10);
+  if (end == fd_str || *end != '\0' || fd < 0) return -1;
+
+  return read_once(fd, NULL, dst, capacity);
+}
+
+static ssize_t load_into(secret_lookup_fn lookup, const void *source, char *dst, size_t capacity) {
+  const char *value;
+
+  if ((value = lookup(source, CLOUDFLARE_API_KEY_FD_ENV_VAR))) return read_token_from_fd_var(value, dst, capacity);
+
+  if ((value = lookup(source, CLOUDFLARE_API_KEY_FILE_ENV_VAR))) return read_token_from_path(value, dst, capacity);
+
+  if ((value = lookup(source, CREDENTIALS_DIRECTORY_ENV_VAR))) {
+    char path[MAX_STRING_LENGTH];
+    int n = snprintf(path, sizeof(path), "%s/%s", value, CLOUDFLARE_API_KEY_CREDENTIAL);
+
+    if (n > 0 && (size_t) n < sizeof(path) && access(path, R_OK) == 0) return read_token_from_path(path, dst, capacity);
+  }
+
+  if ((value = lookup(source, CLOUDFLARE_API_KEY_ENV_VAR))) {
+    // An env file is parsed again on every reload; the environment is not.
+    if (value == getenv(CLOUDFLARE_API_KEY_ENV_VAR)) return read_once(-1, value, dst, capacity);
+
+    return copy_and_wipe(value, dst, capacity);
+  }
+
+  return -1;
+}
+
+const char *secret_load_api_key(Secret *secret, secret_lookup_fn lookup, const void *source) {
+  secret_wipe(secret);
+
+  prctl(PR_SET_DUMPABLE, 0, 0, 0, 0);
+
+  char *page = map_locked_page();
+  if (!page) {
+    error_set(ERR_ALLOC_FAILURE);
+    return NULL;
+  }
+
+  // One spare byte lets an over-long token be detected instead of truncated.
+  ssize_t len = load_into(lookup, source, page, MAX_CLOUDFLARE_API_KEY_LENGTH + 1);
+
+  if (len < MIN_CLOUDFLARE_API_KEY_LENGTH || len > MAX_CLOUDFLARE_API_KEY_LENGTH) {
+    explicit_bzero(page, SECRET_PAGE_SIZE);
+    munmap(page, SECRET_PAGE_SIZE);
+    error_set(ERR_INVALID_ENV_CLOUDFLARE_KEY);
+    return NULL;
+  }
+
+  page[len] = '\0';
+
+  secret->page = page;
+  secret->header = (AuthHeader) {
+      .parts = {
+          { .iov_base = (void *) AUTH_HEADER_PREFIX, .iov_len = sizeof(AUTH_HEADER_PREFIX) - 1 },
+          { .iov_base = page, .iov_len = (size_t) len },
+          { .iov_base = (void *) AUTH_HEADER_SUFFIX, .iov_len = sizeof(AUTH_HEADER_SUFFIX) - 1 },
+      },
+      .length = sizeof(AUTH_HEADER_PREFIX) - 1 + (size_t) len + sizeof(AUTH_HEADER_SUFFIX) - 1,
+  };
+
+  return page;
+}
+
+AuthHeader secret_auth_header(const Secret *secret) {
+  return secret->header;
+}
+
+void secret_wipe(Secret *secret) {
+  if (!secret->page) return;
+
+  explicit_bzero(secret->page, SECRET_PAGE_SIZE);
+  munlock(secret->page, SECRET_PAGE_SIZE);
+  munmap(secret->page, SECRET_PAGE_SIZE);
+
+  memset(secret, 0, sizeof(Secret));
+}
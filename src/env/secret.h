@@ -0,0 +1,53 @@
+#pragma once
+
+#include <sys/uio.h>
+
+#include "../common.h"
+#include "../errors/errors.h"
+
+// The API token lives in one mlock'd, MADV_DONTDUMP page. The auth header is
+// a precomputed iovec block whose middle part points into that page:
+//
+//   "Authorization: Bearer " | <token> | "\r\n"
+//
+// Requests hand it to writev()/SSL writes as-is instead of formatting the
+// token into per-request buffers. Nothing sends one yet: its consumer is the
+// Cloudflare API client, still in old/, which is also what --check-config's
+// token and zone checks are waiting for.
+struct auth_header {
+  struct iovec parts[3];
+  size_t length;
+};
+
+typedef struct auth_header AuthHeader;
+
+// The token of one configuration snapshot; each Env owns one, so a reload
+// resolves the token again and the old page is wiped with the old snapshot.
+struct secret {
+  char *page;
+  AuthHeader header;
+};
+
+typedef struct secret Secret;
+
+typedef const char *(*secret_lookup_fn)(const void *source, const char *key);
+
+// Loads the token into `secret`, trying in order:
+//   1. CLOUDFLARE_API_KEY_FD    inherited file descriptor
+//   2. CLOUDFLARE_API_KEY_FILE  path (Kubernetes secret mount, ...)
+//   3. $CREDENTIALS_DIRECTORY/cloudflare_api_key  (systemd LoadCredential=)
+//   4. CLOUDFLARE_API_KEY       plain variable, wiped in place after copying
+//                               so it no longer shows in /proc/self/environ
+// Files are read again on every load, so a rotated token is picked up. A
+// descriptor and the process environment can only be consumed once: their
+// token is kept in a process-wide locked page (under a lock) and reused while
+// the same source stays configured. Also marks the process non-dumpable.
+// Returns the token (NUL-terminated, inside the locked page) or NULL with
+// ERR_INVALID_ENV_CLOUDFLARE_KEY set.
+const char *secret_load_api_key(Secret *secret, secret_lookup_fn lookup, const void *source);
+
+// Empty until secret_load_api_key() succeeds.
+AuthHeader secret_auth_header(const Secret *secret);
+
+// Zeroes, unlocks and unmaps the page. No-op on an empty secret.
+void secret_wipe(Secret *secret);
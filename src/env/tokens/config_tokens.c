@@ -0,0 +1,22 @@
+#include "config_tokens.h"
+
+#include "config_tokens_table.h"
+
+const ConfigToken *config_token_lookup(const char *str, size_t len, token_kind_t kind) {
+  while (len > 0 && isspace((unsigned char) *str)) str++, len--;
+  while (len > 0 && isspace((unsigned char) str[len - 1])) len--;
+
+  if (len == 0 || len > CONFIG_TOKEN_MAX_LENGTH) return NULL;
+
+  uint32_t slot = config_token_hash(str, len, CONFIG_TOKEN_SEED) & (CONFIG_TOKEN_TABLE_SIZE - 1);
+  const ConfigToken *token = &CONFIG_TOKEN_TABLE[slot];
+
+  if (token->length != len || token->kind != kind) return NULL;
+
+  // Tokens are stored lowercase.
+  for (size_t i = 0; i < len; i++) {
+    if (tolower((unsigned char) str[i]) != token->text[i]) return NULL;
+  }
+
+  return token;
+}
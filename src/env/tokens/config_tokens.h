@@ -0,0 +1,51 @@
+#pragma once
+
+#include "../../common.h"
+
+typedef enum {
+  TOKEN_KIND_BOOL,
+  TOKEN_KIND_LOG_LEVEL,
+  TOKEN_KIND_PROVIDER_FORMAT,
+} token_kind_t;
+
+typedef enum {
+  LOG_LEVEL_ERROR,
+  LOG_LEVEL_WARN,
+  LOG_LEVEL_INFO,
+  LOG_LEVEL_DEBUG,
+  LOG_LEVEL_TRACE,
+} log_level_t;
+
+// How an IP provider answers: bare address, JSON document or HTML page.
+typedef enum {
+  PROVIDER_FORMAT_TEXT,
+  PROVIDER_FORMAT_JSON,
+  PROVIDER_FORMAT_HTML,
+} provider_format_t;
+
+struct config_token {
+  const char *text;
+  uint8_t length;
+  uint8_t kind;
+  uint8_t value;
+};
+
+typedef struct config_token ConfigToken;
+
+// FNV-1a over the lowercased bytes, folded. Shared with the table
+// generator (tools/gen_config_tokens.c), which picks `seed` so every token
+// lands in its own slot.
+static inline uint32_t config_token_hash(const char *str, size_t len, uint32_t seed) {
+  uint32_t h = 2166136261u ^ seed;
+
+  for (size_t i = 0; i < len; i++) {
+    h ^= (uint8_t) (str[i] | 0x20);
+    h *= 16777619u;
+  }
+
+  return h ^ (h >> 15);
+}
+
+// One hash and one compare. `str` need not be NUL-terminated nor trimmed
+// (surrounding whitespace is skipped). NULL when unknown or of another kind.
+const ConfigToken *config_token_lookup(const char *str, size_t len, token_kind_t kind);
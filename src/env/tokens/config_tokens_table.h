@@ -0,0 +1,31 @@
+// Generated by tools/gen_config_tokens.c from config_tokens.def. Do not edit.
+#pragma once
+
+#define CONFIG_TOKEN_SEED 0x0000000au
+#define CONFIG_TOKEN_TABLE_SIZE 64u
+#define CONFIG_TOKEN_MAX_LENGTH 8
+
+static const ConfigToken CONFIG_TOKEN_TABLE[CONFIG_TOKEN_TABLE_SIZE] = {
+    [3] = { "1", 1, TOKEN_KIND_BOOL, 1 },
+    [6] = { "true", 4, TOKEN_KIND_BOOL, 1 },
+    [12] = { "html", 4, TOKEN_KIND_PROVIDER_FORMAT, 2 },
+    [14] = { "off", 3, TOKEN_KIND_BOOL, 0 },
+    [15] = { "enabled", 7, TOKEN_KIND_BOOL, 1 },
+    [16] = { "false", 5, TOKEN_KIND_BOOL, 0 },
+    [23] = { "warning", 7, TOKEN_KIND_LOG_LEVEL, 1 },
+    [25] = { "text", 4, TOKEN_KIND_PROVIDER_FORMAT, 0 },
+    [28] = { "info", 4, TOKEN_KIND_LOG_LEVEL, 2 },
+    [31] = { "plain", 5, TOKEN_KIND_PROVIDER_FORMAT, 0 },
+    [32] = { "json", 4, TOKEN_KIND_PROVIDER_FORMAT, 1 },
+    [34] = { "error", 5, TOKEN_KIND_LOG_LEVEL, 0 },
+    [44] = { "yes", 3, TOKEN_KIND_BOOL, 1 },
+    [45] = { "no", 2, TOKEN_KIND_BOOL, 0 },
+    [47] = { "disable", 7, TOKEN_KIND_BOOL, 0 },
+    [51] = { "disabled", 8, TOKEN_KIND_BOOL, 0 },
+    [52] = { "0", 1, TOKEN_KIND_BOOL, 0 },
+    [54] = { "enable", 6, TOKEN_KIND_BOOL, 1 },
+    [56] = { "debug", 5, TOKEN_KIND_LOG_LEVEL, 3 },
+    [60] = { "trace", 5, TOKEN_KIND_LOG_LEVEL, 4 },
+    [62] = { "on", 2, TOKEN_KIND_BOOL, 1 },
+    [63] = { "warn", 4, TOKEN_KIND_LOG_LEVEL, 1 },
+};
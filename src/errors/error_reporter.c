@@ -0,0 +1,79 @@
+#include "error_reporter.h"
+
+static const char *STATUS_LABELS[] = {
+    [CHECK_PASSED] = "OK",
+    [CHECK_FAILED] = "FAIL",
+    [CHECK_SKIPPED] = "SKIP",
+};
+
+bool report_init(ValidationReport *report, size_t capacity) {
+  *report = (ValidationReport) { .items = NULL, .length = 0, .capacity = 0, .failed = 0, .wall_ns = 0 };
+
+  if (capacity == 0) return true;
+
+  report->items = mm_calloc(capacity, sizeof(CheckResult));
+  if (!report->items) return false;
+
+  report->capacity = capacity;
+
+  return true;
+}
+
+bool report_grow(ValidationReport *report, size_t extra) {
+  if (extra == 0) return true;
+
+  CheckResult *items = mm_calloc(report->capacity + extra, sizeof(CheckResult));
+  if (!items) return false;
+
+  if (report->length) memcpy(items, report->items, report->length * sizeof(CheckResult));
+
+  mm_free(report->items);
+  report->items = items;
+  report->capacity += extra;
+
+  return true;
+}
+
+CheckResult *report_reserve(ValidationReport *report, const char *name, const char *subject) {
+  if (report->length >= report->capacity) return NULL;
+
+  CheckResult *result = &report->items[report->length++];
+
+  result->name = name;
+  result->status = CHECK_SKIPPED;
+  result->detail[0] = '\0';
+  result->duration_ns = 0;
+  snprintf(result->subject, sizeof(result->subject), "%s", subject ? subject : "");
+
+  return result;
+}
+
+void report_finish(ValidationReport *report, uint64_t wall_ns) {
+  report->failed = 0;
+
+  for (size_t i = 0; i < report->length; i++) {
+    if (report->items[i].status == CHECK_FAILED) report->failed++;
+  }
+
+  report->wall_ns = wall_ns;
+}
+
+void report_print(const ValidationReport *report, FILE *out) {
+  uint64_t serial_ns = 0;
+
+  for (size_t i = 0; i < report->length; i++) {
+    const CheckResult *r = &report->items[i];
+    serial_ns += r->duration_ns;
+
+    fprintf(out, "[%-4s]  %-8s  %-32s %9.3f ms  %s\n",
+            STATUS_LABELS[r->status], r->name, r->subject, (double) r->duration_ns / 1e6, r->detail);
+  }
+
+  fprintf(out, "%zu checks, %zu failed, %.3f ms wall (%.3f ms if run serially)\n",
+          report->length, report->failed, (double) report->wall_ns / 1e6, (double) serial_ns / 1e6);
+}
+
+void report_free(ValidationReport *report) {
+  mm_free(report->items);
+  *report = (ValidationReport) { .items = NULL, .length = 0, .capacity = 0, .failed = 0, .wall_ns = 0 };
+}
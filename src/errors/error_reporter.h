@@ -0,0 +1,53 @@
+#pragma once
+
+#include "../common.h"
+#include "../errors/errors.h"
+#include "../memory/memory_management.h"
+
+#define CHECK_DETAIL_SIZE 128
+
+typedef enum {
+  CHECK_PASSED,
+  CHECK_FAILED,
+  CHECK_SKIPPED,
+} check_status_t;
+
+// One finding. `name` is static; `subject` is what was checked (a setting,
+// a domain, a provider URL...).
+struct check_result {
+  const char *name;
+  char subject[MAX_URL_LENGTH + 1];
+  check_status_t status;
+  char detail[CHECK_DETAIL_SIZE];
+  uint64_t duration_ns;
+};
+
+typedef struct check_result CheckResult;
+
+struct validation_report {
+  CheckResult *items;
+  size_t length;
+  size_t capacity;
+  size_t failed;
+  uint64_t wall_ns;
+};
+
+typedef struct validation_report ValidationReport;
+
+bool report_init(ValidationReport *report, size_t capacity);
+
+// Makes room for `extra` more results. Must not be called while slots are
+// being filled concurrently.
+bool report_grow(ValidationReport *report, size_t extra);
+
+// Returns the slot to fill, or NULL when the report is full.
+CheckResult *report_reserve(ValidationReport *report, const char *name, const char *subject);
+
+// Recounts failures after slots were filled concurrently.
+void report_finish(ValidationReport *report, uint64_t wall_ns);
+
+// One line per finding plus a summary, e.g.
+//   [FAIL]  format    DOMAINS                 0.004 ms  invalid value
+void report_print(const ValidationReport *report, FILE *out);
+
+void report_free(ValidationReport *report);
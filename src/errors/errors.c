@@ -1,8 +1,17 @@
 #include "../errors/errors.h"
 
-ErrorFlags g_errors = ERR_NONE;
+_Thread_local ErrorContext *t_error_context = NULL;
+
+_Atomic ErrorFlags g_errors_aggregate = ERR_NONE;
+
+static _Thread_local ErrorContext thread_root = { .flags = ERR_NONE, .parent = NULL };
+
+ErrorContext *error_context_current(void) {
+  return t_error_context ? t_error_context : &thread_root;
+}
 
 bool error_matches_any(CombinedErrorCode first, ...) {
+  ErrorFlags flags = error_flags();
   va_list ap;
 
   CombinedErrorCode code = first;
@@ -10,7 +19,7 @@ bool error_matches_any(CombinedErrorCode first, ...) {
   va_start(ap, first);
 
   while (code != ERR_NONE) {
-    if (g_errors & code) {
+    if (flags & code) {
       va_end(ap);
       return true;
     }
@@ -25,12 +34,13 @@ bool error_matches_any(CombinedErrorCode first, ...) {
 
 bool error_matches_all(CombinedErrorCode first, ...)
 {
+  ErrorFlags flags = error_flags();
   va_list ap;
   CombinedErrorCode code = first;
   va_start(ap, first);
 
   while (code != ERR_NONE) {
-    if ((g_errors & code) == 0) {
+    if ((flags & code) == 0) {
       va_end(ap);
       return false;
     }
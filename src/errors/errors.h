@@ -1,8 +1,10 @@
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <stdarg.h>
+#include <stdatomic.h>
 
 // Allows to combine multiple error codes into a single integer.
 // ERROR_A or ERROR_B or ERROR_C can be combined using the bitwise OR operator.
@@ -22,24 +24,78 @@ enum error_signature {
   ERR_ALLOC_FAILURE = 1u << 7,                            // 0x00000080u = 0000 0000 0000 0000 0000 0000 1000 0000
 
   ERR_PARSE = 1u << 8,                                    // 0x00000100u = 0000 0000 0000 0000 0000 0001 0000 0000
+
+  ERR_INVALID_ENV_FILE = 1u << 9,                         // 0x00000200u = 0000 0000 0000 0000 0000 0010 0000 0000
+  ERR_RELOAD = 1u << 10,                                  // 0x00000400u = 0000 0000 0000 0000 0000 0100 0000 0000
+
+  ERR_INVALID_ENV_LOG_LEVEL = 1u << 11,                   // 0x00000800u = 0000 0000 0000 0000 0000 1000 0000 0000
+
+  ERR_REMOTE_CHECK = 1u << 12,                            // 0x00001000u = 0000 0000 0000 0000 0001 0000 0000 0000
+
+  ERR_INVALID_ENV_METRICS_LISTEN = 1u << 13,              // 0x00002000u = 0000 0000 0000 0000 0010 0000 0000 0000
+  ERR_INVALID_ENV_CYCLE_BUDGET = 1u << 14,                // 0x00004000u = 0000 0000 0000 0000 0100 0000 0000 0000
+  ERR_INVALID_ENV_CONTROL_SOCKET = 1u << 15,              // 0x00008000u = 0000 0000 0000 0000 1000 0000 0000 0000
+  ERR_INVALID_ENV_DETECTION_GROUP = 1u << 16,             // 0x00010000u = 0000 0000 0000 0001 0000 0000 0000 0000
+  ERR_INVALID_ENV_IP_SNAPSHOT = 1u << 17,                 // 0x00020000u = 0000 0000 0000 0010 0000 0000 0000 0000
+  ERR_INVALID_ENV_STATE_MAX_AGE = 1u << 18,               // 0x00040000u = 0000 0000 0000 0100 0000 0000 0000 0000
 };
 
 typedef enum error_signature CombinedErrorCode;
 
 typedef uint32_t ErrorFlags;
 
-extern ErrorFlags g_errors;
+// Errors are recorded in the calling thread's current context: either its
+// implicit thread-wide root or the innermost scope opened with
+// error_scope_begin(). Every error_set() is also OR-ed (relaxed, atomically)
+// into a process-wide aggregate, so concurrent workers never race on the
+// same word while the main thread can still see "did anything fail".
+//
+//   ErrorContext ctx;
+//   error_scope_begin(&ctx);
+//   update_domain(domain);            // error_set()/error_has() hit ctx
+//   result->errors = error_scope_end(&ctx);
+struct error_context {
+  ErrorFlags flags;
+  struct error_context *parent;
+};
+
+typedef struct error_context ErrorContext;
+
+extern _Thread_local ErrorContext *t_error_context;
+
+extern _Atomic ErrorFlags g_errors_aggregate;
+
+ErrorContext *error_context_current(void);
+
+static inline void error_scope_begin(ErrorContext *ctx) {
+  ctx->flags = ERR_NONE;
+  ctx->parent = t_error_context;
+  t_error_context = ctx;
+}
+
+// Closes the innermost scope and returns what was recorded in it. Nothing
+// is propagated to the parent; callers that want that do error_set() on the
+// returned flags.
+static inline ErrorFlags error_scope_end(ErrorContext *ctx) {
+  t_error_context = ctx->parent;
+  return ctx->flags;
+}
 
 static inline void error_set(CombinedErrorCode e) {
-  g_errors |= e;
+  error_context_current()->flags |= e;
+  atomic_fetch_or_explicit(&g_errors_aggregate, (ErrorFlags) e, memory_order_relaxed);
 }
 
 static inline bool error_has(CombinedErrorCode e) {
-  return (g_errors & e) != 0;
+  return (error_context_current()->flags & e) != 0;
 }
 
 static inline bool error_has_eny(void) {
-  return g_errors!= ERR_NONE;
+  return error_context_current()->flags != ERR_NONE;
+}
+
+static inline ErrorFlags error_flags(void) {
+  return error_context_current()->flags;
 }
 
 bool error_matches_any(CombinedErrorCode first, ...);
@@ -47,10 +103,18 @@ bool error_matches_any(CombinedErrorCode first, ...);
 bool error_matches_all(CombinedErrorCode first, ...);
 
 static inline void error_clear(CombinedErrorCode e) {
-  g_errors &= ~e;
+  error_context_current()->flags &= ~e;
 }
 
 static inline void error_reset(void) {
-  g_errors = ERR_NONE;
+  error_context_current()->flags = ERR_NONE;
+}
+
+// Process-wide view: every error set by any thread since the last reset.
+static inline ErrorFlags error_global(void) {
+  return atomic_load_explicit(&g_errors_aggregate, memory_order_relaxed);
 }
 
+static inline void error_global_reset(void) {
+  atomic_store_explicit(&g_errors_aggregate, ERR_NONE, memory_order_relaxed);
+}
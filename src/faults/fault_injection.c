@@ -0,0 +1,107 @@
+#include "fault_injection.h"
+
+#ifdef ENABLE_FAULT_INJECTION
+
+#include <stdatomic.h>
+#include <time.h>
+
+#define FAULTS_ENV_VAR "FAULTS"
+#define FAULT_SEED_ENV_VAR "FAULT_SEED"
+#define DEFAULT_FAULT_LATENCY_MS 250
+
+typedef enum {
+  KIND_LATENCY,
+  KIND_TIMEOUT,
+  KIND_RESET,
+  KIND_TRUNCATE,
+  KIND_TLS,
+  KIND_ALLOC,
+  KIND_COUNT
+} fault_kind_t;
+
+#define SITE_BIT(site) (1u << (site))
+#define NETWORK_SITES (SITE_BIT(FAULT_SITE_SOCKET) | SITE_BIT(FAULT_SITE_TLS) | SITE_BIT(FAULT_SITE_HTTP))
+
+static const struct {
+  const char *name;
+  fault_t result;
+  unsigned int sites;
+} KINDS[KIND_COUNT] = {
+    [KIND_LATENCY] = { "latency", FAULT_NONE, NETWORK_SITES },
+    [KIND_TIMEOUT] = { "timeout", FAULT_TIMEOUT, SITE_BIT(FAULT_SITE_SOCKET) | SITE_BIT(FAULT_SITE_HTTP) },
+    [KIND_RESET] = { "reset", FAULT_RESET, SITE_BIT(FAULT_SITE_SOCKET) },
+    [KIND_TRUNCATE] = { "truncate", FAULT_TRUNCATE, SITE_BIT(FAULT_SITE_HTTP) },
+    [KIND_TLS] = { "tls", FAULT_TLS_FAILURE, SITE_BIT(FAULT_SITE_TLS) },
+    [KIND_ALLOC] = { "alloc", FAULT_ALLOC_FAILURE, SITE_BIT(FAULT_SITE_ALLOC) },
+};
+
+// Probabilities are kept as thresholds on a 32-bit draw.
+static uint32_t thresholds[KIND_COUNT];
+static unsigned int latency_ms = DEFAULT_FAULT_LATENCY_MS;
+static uint64_t seed = 0;
+static bool enabled = false;
+static _Atomic uint64_t calls[FAULT_SITE_COUNT];
+
+// Parsing must not allocate: mm_malloc is itself an injection site.
+void faults_init(void) {
+  const char *spec = getenv(FAULTS_ENV_VAR);
+  const char *seed_str = getenv(FAULT_SEED_ENV_VAR);
+
+  seed = seed_str ? strtoull(seed_str, NULL, 0) : 0;
+
+  for (const char *p = spec; p && *p;) {
+    size_t len = strcspn(p, ",");
+    const char *eq = memchr(p, '=', len);
+
+    for (size_t k = 0; eq && k < KIND_COUNT; k++) {
+      if (strlen(KINDS[k].name) != (size_t) (eq - p) || strncmp(p, KINDS[k].name, (size_t) (eq - p)) != 0) continue;
+
+      char *end;
+      double probability = strtod(eq + 1, &end);
+
+      if (probability > 0) {
+        thresholds[k] = probability >= 1 ? UINT32_MAX : (uint32_t) (probability * UINT32_MAX);
+        enabled = true;
+      }
+
+      if (k == KIND_LATENCY && *end == ':') latency_ms = (unsigned int) strtoul(end + 1, NULL, 10);
+    }
+
+    p += len;
+    if (*p == ',') p++;
+  }
+}
+
+static uint64_t splitmix64(uint64_t x) {
+  x += 0x9e3779b97f4a7c15ull;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+
+  return x ^ (x >> 31);
+}
+
+fault_t fault_inject(fault_site_t site) {
+  if (!enabled) return FAULT_NONE;
+
+  uint64_t n = atomic_fetch_add_explicit(&calls[site], 1, memory_order_relaxed);
+  uint64_t state = splitmix64(splitmix64(seed ^ ((uint64_t) site << 56)) + n);
+
+  for (size_t k = 0; k < KIND_COUNT; k++) {
+    if (!(KINDS[k].sites & SITE_BIT(site)) || thresholds[k] == 0) continue;
+
+    state = splitmix64(state);
+    if ((uint32_t) state >= thresholds[k]) continue;
+
+    if (k == KIND_LATENCY) {
+      struct timespec delay = { .tv_sec = latency_ms / 1000, .tv_nsec = (long) (latency_ms % 1000) * 1000000L };
+      nanosleep(&delay, NULL);
+      continue;
+    }
+
+    return KINDS[k].result;
+  }
+
+  return FAULT_NONE;
+}
+
+#endif
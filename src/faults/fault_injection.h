@@ -0,0 +1,48 @@
+#pragma once
+
+#include "../common.h"
+
+// Where a fault can be injected.
+typedef enum {
+  FAULT_SITE_ALLOC,     // mm_malloc / mm_calloc
+  FAULT_SITE_SOCKET,    // connect / send / recv
+  FAULT_SITE_TLS,       // handshake
+  FAULT_SITE_HTTP,      // get_url_body: the whole request
+  FAULT_SITE_COUNT
+} fault_site_t;
+
+// What the call site should pretend happened. Latency is not listed: it is
+// applied inside fault_inject() itself and the call then proceeds normally.
+typedef enum {
+  FAULT_NONE,
+  FAULT_TIMEOUT,
+  FAULT_RESET,
+  FAULT_TRUNCATE,
+  FAULT_TLS_FAILURE,
+  FAULT_ALLOC_FAILURE,
+} fault_t;
+
+// Only built with -DENABLE_FAULT_INJECTION. Faults are configured through
+//
+//   FAULTS="alloc=0.01,latency=0.2:500,timeout=0.05,reset=0.05,truncate=0.1,tls=0.05"
+//   FAULT_SEED=42
+//
+// Each entry is kind=probability, latency takes a delay in ms after ':'.
+// Decisions derive from (seed, site, n-th call at that site), so a run with
+// the same seed injects the same faults at the same calls.
+#ifdef ENABLE_FAULT_INJECTION
+
+void faults_init(void);
+
+fault_t fault_inject(fault_site_t site);
+
+#else
+
+static inline void faults_init(void) {}
+
+static inline fault_t fault_inject(fault_site_t site) {
+  (void) site;
+  return FAULT_NONE;
+}
+
+#endif
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "../common.h"
+
+#include "../errors/errors.h"
+#include "../faults/fault_injection.h"
+#include "../memory/memory_management.h"
+#include "../logging/log.h"
+
+#include "../daemon/control.h"
+#include "../daemon/daemon.h"
+#include "../daemon/ip_snapshot.h"
+#include "../env/config_check.h"
+#include "../env/env_parser.h"
+#include "../metrics/latency_store.h"
+#include "../state/state_file.h"
+#include "../utils/time_utils.h"
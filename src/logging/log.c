@@ -0,0 +1,297 @@
+#include "log.h"
+
+#include <pthread.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#define LOG_BATCH_SIZE 16384
+#define LOG_LINE_SIZE 512
+
+struct log_message_info {
+  log_level_t level;
+  const char *format;
+};
+
+static const struct log_message_info MESSAGES[LOG_MSG_COUNT] = {
+#define LOG_MESSAGE(id, lvl, fmt) [id] = { .level = lvl, .format = fmt },
+#include "log_messages.def"
+#undef LOG_MESSAGE
+};
+
+static const char *LEVEL_NAMES[] = { "ERROR", "WARN ", "INFO ", "DEBUG", "TRACE" };
+
+static const char *LEVEL_COLORS[] = { "\033[0;31m", "\033[0;33m", "\033[0;36m", "\033[0;37m", "\033[0;90m" };
+
+#define COLOR_RESET "\033[0m"
+
+// Bounded MPSC queue (Vyukov): each slot's sequence number says whether it
+// is free for the producer that claimed position `pos` (seq == pos) or
+// holds a record ready for the consumer (seq == pos + 1).
+struct log_slot {
+  atomic_size_t seq;
+  LogRecord record;
+};
+
+static struct {
+  bool initialized;
+  int fd;
+  bool use_colors;
+  log_level_t level;
+  pthread_t writer;
+  int wake_fd;             // eventfd the idle writer blocks on
+  atomic_bool sleeping;    // writer found the ring empty and is (about to be) blocked
+  atomic_bool stopping;
+  atomic_size_t enqueue_pos;
+  size_t dequeue_pos;
+  atomic_uint dropped;
+  struct log_slot slots[LOG_RING_CAPACITY];
+} log_state;
+
+bool log_enabled(log_message_t message) {
+  return log_state.initialized && MESSAGES[message].level <= log_state.level;
+}
+
+static void wake_writer(void) {
+  uint64_t one = 1;
+
+  // Cannot fail short of the counter overflowing, which still wakes it.
+  if (write(log_state.wake_fd, &one, sizeof(one)) < 0) return;
+}
+
+void log_emit(log_message_t message, const char *str, const uint64_t *args, size_t argc) {
+  if (!log_state.initialized) return;
+
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+
+  size_t pos = atomic_load_explicit(&log_state.enqueue_pos, memory_order_relaxed);
+  struct log_slot *slot;
+
+  for (;;) {
+    slot = &log_state.slots[pos & (LOG_RING_CAPACITY - 1)];
+    size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+    intptr_t diff = (intptr_t) seq - (intptr_t) pos;
+
+    if (diff == 0) {
+      if (atomic_compare_exchange_weak_explicit(&log_state.enqueue_pos, &pos, pos + 1,
+                                                memory_order_relaxed, memory_order_relaxed)) break;
+    } else if (diff < 0) {
+      atomic_fetch_add_explicit(&log_state.dropped, 1, memory_order_relaxed);
+      return;
+    } else {
+      pos = atomic_load_explicit(&log_state.enqueue_pos, memory_order_relaxed);
+    }
+  }
+
+  LogRecord *rec = &slot->record;
+  rec->timestamp_ns = (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+  rec->message = (uint16_t) message;
+  rec->argc = (uint8_t) MIN(argc, LOG_MAX_ARGS);
+  memcpy(rec->args, args, rec->argc * sizeof(uint64_t));
+
+  if (str) {
+    size_t len = strnlen(str, LOG_INLINE_STRING_SIZE - 1);
+    memcpy(rec->str, str, len);
+    rec->str[len] = '\0';
+  } else {
+    rec->str[0] = '\0';
+  }
+
+  atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+
+  // Only the record that finds the writer asleep pays for the wakeup; the
+  // fence pairs with the one in wait_for_records().
+  atomic_thread_fence(memory_order_seq_cst);
+
+  if (atomic_load_explicit(&log_state.sleeping, memory_order_relaxed) &&
+      atomic_exchange_explicit(&log_state.sleeping, false, memory_order_relaxed)) {
+    wake_writer();
+  }
+}
+
+static bool dequeue(LogRecord *out) {
+  struct log_slot *slot = &log_state.slots[log_state.dequeue_pos & (LOG_RING_CAPACITY - 1)];
+  size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+
+  if (seq != log_state.dequeue_pos + 1) return false;
+
+  *out = slot->record;
+  atomic_store_explicit(&slot->seq, log_state.dequeue_pos + LOG_RING_CAPACITY, memory_order_release);
+  log_state.dequeue_pos++;
+
+  return true;
+}
+
+static bool ring_empty(void) {
+  const struct log_slot *slot = &log_state.slots[log_state.dequeue_pos & (LOG_RING_CAPACITY - 1)];
+
+  return atomic_load_explicit(&slot->seq, memory_order_acquire) != log_state.dequeue_pos + 1 &&
+         atomic_load_explicit(&log_state.dropped, memory_order_relaxed) == 0;
+}
+
+static size_t format_message(char *dst, size_t size, const LogRecord *rec) {
+  const char *fmt = MESSAGES[rec->message].format;
+  size_t len = 0, arg = 0;
+
+  for (const char *c = fmt; *c && len + 1 < size; c++) {
+    if (*c != '%' || c[1] == '\0') {
+      dst[len++] = *c;
+      continue;
+    }
+
+    uint64_t value = arg < rec->argc ? rec->args[arg] : 0;
+    int n = 0;
+
+    switch (*++c) {
+      case 's': n = snprintf(dst + len, size - len, "%s", rec->str); break;
+      case 'd': n = snprintf(dst + len, size - len, "%lld", (long long) value); arg++; break;
+      case 'u': n = snprintf(dst + len, size - len, "%llu", (unsigned long long) value); arg++; break;
+      case 'x': n = snprintf(dst + len, size - len, "%llx", (unsigned long long) value); arg++; break;
+      default: dst[len++] = *c; break;
+    }
+
+    if (n > 0) len = MIN(len + (size_t) n, size - 1);
+  }
+
+  dst[len] = '\0';
+
+  return len;
+}
+
+static size_t format_record(char *dst, size_t size, const LogRecord *rec) {
+  log_level_t level = MESSAGES[rec->message].level;
+  time_t secs = (time_t) (rec->timestamp_ns / 1000000000ull);
+  struct tm tm_info;
+  localtime_r(&secs, &tm_info);
+
+  char message[LOG_LINE_SIZE];
+  format_message(message, sizeof(message), rec);
+
+  int n = snprintf(dst, size, "%s[%02d:%02d:%02d.%03u %s]%s %s\n",
+                   log_state.use_colors ? LEVEL_COLORS[level] : "",
+                   tm_info.tm_hour, tm_info.tm_min, tm_info.tm_sec,
+                   (unsigned) (rec->timestamp_ns / 1000000ull % 1000),
+                   LEVEL_NAMES[level],
+                   log_state.use_colors ? COLOR_RESET : "",
+                   message);
+
+  return n < 0 ? 0 : MIN((size_t) n, size - 1);
+}
+
+static void write_all(const char *buf, size_t len) {
+  while (len > 0) {
+    ssize_t n = write(log_state.fd, buf, len);
+    if (n <= 0) return;
+
+    buf += n;
+    len -= (size_t) n;
+  }
+}
+
+// Formats everything queued into one buffer and writes it with as few
+// syscalls as possible. Returns the number of records written.
+static size_t drain(void) {
+  static char batch[LOG_BATCH_SIZE];
+  size_t len = 0, count = 0;
+  LogRecord rec;
+
+  unsigned int dropped = atomic_exchange_explicit(&log_state.dropped, 0, memory_order_relaxed);
+  if (dropped) {
+    rec = (LogRecord) { .message = LOG_MSG_LOGS_DROPPED, .argc = 1, .args = { dropped } };
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    rec.timestamp_ns = (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+    len += format_record(batch + len, sizeof(batch) - len, &rec);
+  }
+
+  while (dequeue(&rec)) {
+    if (sizeof(batch) - len < LOG_LINE_SIZE) {
+      write_all(batch, len);
+      len = 0;
+    }
+
+    len += format_record(batch + len, sizeof(batch) - len, &rec);
+    count++;
+  }
+
+  if (len) write_all(batch, len);
+
+  return count;
+}
+
+// Blocks until log_emit() or log_shutdown() signals the eventfd. The ring is
+// checked again after announcing the sleep, so a record published in between
+// is not left waiting.
+static void wait_for_records(void) {
+  atomic_store_explicit(&log_state.sleeping, true, memory_order_relaxed);
+  atomic_thread_fence(memory_order_seq_cst);
+
+  if (ring_empty() && !atomic_load_explicit(&log_state.stopping, memory_order_acquire)) {
+    uint64_t count;
+    if (read(log_state.wake_fd, &count, sizeof(count)) < 0) return;
+  }
+
+  atomic_store_explicit(&log_state.sleeping, false, memory_order_relaxed);
+}
+
+// Sleeps on the eventfd while idle. Once records arrive they are flushed
+// every LOG_FLUSH_INTERVAL_MS until the ring stays empty, so a burst is
+// written in a few large batches.
+static void *writer_thread(void *arg) {
+  (void) arg;
+  struct timespec pause = { .tv_sec = 0, .tv_nsec = LOG_FLUSH_INTERVAL_MS * 1000000L };
+
+  for (;;) {
+    if (drain() > 0) {
+      nanosleep(&pause, NULL);
+      continue;
+    }
+
+    if (atomic_load_explicit(&log_state.stopping, memory_order_acquire)) break;
+
+    wait_for_records();
+  }
+
+  drain();
+
+  return NULL;
+}
+
+int log_init(int fd, log_level_t level) {
+  if (log_state.initialized) return 0;
+
+  log_state.fd = fd;
+  log_state.level = level;
+  log_state.use_colors = isatty(fd);
+  log_state.dequeue_pos = 0;
+  atomic_init(&log_state.enqueue_pos, 0);
+  atomic_init(&log_state.dropped, 0);
+  atomic_init(&log_state.sleeping, false);
+  atomic_init(&log_state.stopping, false);
+
+  for (size_t i = 0; i < LOG_RING_CAPACITY; i++) atomic_init(&log_state.slots[i].seq, i);
+
+  log_state.wake_fd = eventfd(0, EFD_CLOEXEC);
+  if (log_state.wake_fd < 0) return -1;
+
+  if (pthread_create(&log_state.writer, NULL, writer_thread, NULL) != 0) {
+    close(log_state.wake_fd);
+    return -1;
+  }
+
+  log_state.initialized = true;
+
+  return 0;
+}
+
+void log_shutdown(void) {
+  if (!log_state.initialized) return;
+
+  atomic_store_explicit(&log_state.stopping, true, memory_order_release);
+
+  wake_writer();
+  pthread_join(log_state.writer, NULL);
+  close(log_state.wake_fd);
+
+  log_state.initialized = false;
+}
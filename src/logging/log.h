@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stdatomic.h>
+
+#include "../common.h"
+#include "../env/tokens/config_tokens.h"
+
+typedef enum {
+#define LOG_MESSAGE(id, level, format) id,
+#include "log_messages.def"
+#undef LOG_MESSAGE
+  LOG_MSG_COUNT
+} log_message_t;
+
+#define LOG_MAX_ARGS 4
+#define LOG_INLINE_STRING_SIZE 48
+#define LOG_RING_CAPACITY 1024  // power of two
+#define LOG_FLUSH_INTERVAL_MS 20  // batching while records keep arriving
+
+// Binary record: formatting happens on the writer thread.
+struct log_record {
+  uint64_t timestamp_ns;
+  uint16_t message;
+  uint8_t argc;
+  uint64_t args[LOG_MAX_ARGS];
+  char str[LOG_INLINE_STRING_SIZE];
+};
+
+typedef struct log_record LogRecord;
+
+// Starts the writer thread on `fd`. Whether to colorize is decided here,
+// once. Records below `level` are discarded by the caller.
+int log_init(int fd, log_level_t level);
+
+// Drains whatever is queued, then stops the writer thread.
+void log_shutdown(void);
+
+bool log_enabled(log_message_t message);
+
+// Never blocks: on a full ring the record is dropped and counted. `str` is
+// copied (truncated to LOG_INLINE_STRING_SIZE - 1) so it may be transient.
+void log_emit(log_message_t message, const char *str, const uint64_t *args, size_t argc);
+
+#define LOG(message, str, ...)                                                          \
+  do {                                                                                  \
+    if (log_enabled(message)) {                                                         \
+      const uint64_t log_args_[] = { 0, ##__VA_ARGS__ };                                \
+      log_emit((message), (str), log_args_ + 1, ARRAY_SIZE(log_args_) - 1);             \
+    }                                                                                   \
+  } while (0)
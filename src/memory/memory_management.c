@@ -1,9 +1,49 @@
 #include "memory_management.h"
 
+#include <malloc.h>
+#include <stdatomic.h>
+
+#include "../faults/fault_injection.h"
+#include "../logging/log.h"
+#include "../tracing/probes.h"
+
+static struct {
+  atomic_size_t total_allocated;
+  atomic_size_t current_allocated;
+  atomic_size_t peak_allocated;
+  atomic_size_t allocation_count;
+  atomic_size_t deallocation_count;
+  atomic_size_t failed_allocations;
+  atomic_size_t retry_count;
+} stats;
+
+static inline void stat_add(atomic_size_t *stat, size_t value) {
+  atomic_fetch_add_explicit(stat, value, memory_order_relaxed);
+}
+
+static void track_alloc(void *ptr, unsigned int retries) {
+  size_t size = malloc_usable_size(ptr);
+  size_t current = atomic_fetch_add_explicit(&stats.current_allocated, size, memory_order_relaxed) + size;
+  size_t peak = atomic_load_explicit(&stats.peak_allocated, memory_order_relaxed);
+
+  while (current > peak &&
+         !atomic_compare_exchange_weak_explicit(&stats.peak_allocated, &peak, current,
+                                                memory_order_relaxed, memory_order_relaxed)) {}
+
+  stat_add(&stats.total_allocated, size);
+  stat_add(&stats.allocation_count, 1);
+  if (retries) stat_add(&stats.retry_count, retries);
+}
+
 static void *try_alloc(alloc_mode_t mode, size_t arg0, size_t arg1) {
   void *ptr = NULL;
+  unsigned int i = 0;
+
+  // An injected failure skips the retries: it stands for malloc having
+  // failed MAX_MALLOC_RETRIES times.
+  bool injected = fault_inject(FAULT_SITE_ALLOC) == FAULT_ALLOC_FAILURE;
 
-  for (unsigned int i = 0; ptr == NULL && i < MAX_MALLOC_RETRIES; i++) {
+  for (; !injected && ptr == NULL && i < MAX_MALLOC_RETRIES; i++) {
     if (mode == ALLOC_MODE_MALLOC) {
       ptr = malloc(arg0);
     } else {
@@ -11,7 +51,14 @@ static void *try_alloc(alloc_mode_t mode, size_t arg0, size_t arg1) {
     }
   }
 
-  if (ptr == NULL) error_set(ERR_ALLOC_FAILURE);
+  if (ptr == NULL) {
+    PROBE_ALLOC_FAILURE(mode == ALLOC_MODE_MALLOC ? arg0 : arg0 * arg1);
+    stat_add(&stats.failed_allocations, 1);
+    error_set(ERR_ALLOC_FAILURE);
+    LOG(LOG_MSG_ALLOC_FAILURE, NULL, mode == ALLOC_MODE_MALLOC ? arg0 : arg0 * arg1);
+  } else {
+    track_alloc(ptr, i - 1);
+  }
 
   return ptr;
 }
@@ -25,5 +72,20 @@ void *mm_calloc(size_t nmemb, size_t size) {
 }
 
 void mm_free(void *ptr) {
+  if (ptr) {
+    atomic_fetch_sub_explicit(&stats.current_allocated, malloc_usable_size(ptr), memory_order_relaxed);
+    stat_add(&stats.deallocation_count, 1);
+  }
+
   free(ptr);
 }
+
+void memory_get_stats(memory_stats_t *out) {
+  out->total_allocated = atomic_load_explicit(&stats.total_allocated, memory_order_relaxed);
+  out->current_allocated = atomic_load_explicit(&stats.current_allocated, memory_order_relaxed);
+  out->peak_allocated = atomic_load_explicit(&stats.peak_allocated, memory_order_relaxed);
+  out->allocation_count = atomic_load_explicit(&stats.allocation_count, memory_order_relaxed);
+  out->deallocation_count = atomic_load_explicit(&stats.deallocation_count, memory_order_relaxed);
+  out->failed_allocations = atomic_load_explicit(&stats.failed_allocations, memory_order_relaxed);
+  out->retry_count = atomic_load_explicit(&stats.retry_count, memory_order_relaxed);
+}
@@ -1,3 +1,5 @@
+#pragma once
+
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -10,11 +12,25 @@ typedef enum {
   ALLOC_MODE_CALLOC
 } alloc_mode_t;
 
+// Same fields as the old http_client memory module. Kept with relaxed
+// atomics so any thread can allocate while metrics are scraped.
+typedef struct {
+  size_t total_allocated;     // Total bytes allocated
+  size_t current_allocated;   // Currently allocated bytes
+  size_t peak_allocated;      // Peak allocation
+  size_t allocation_count;    // Number of allocations
+  size_t deallocation_count;  // Number of deallocations
+  size_t failed_allocations;  // Failed allocation attempts
+  size_t retry_count;         // Number of retries performed
+} memory_stats_t;
+
 void *mm_malloc(size_t size);
 
 void *mm_calloc(size_t nmemb, size_t size);
 
 void mm_free(void *ptr);
 
+void memory_get_stats(memory_stats_t *stats);
+
 
 
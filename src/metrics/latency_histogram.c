@@ -0,0 +1,102 @@
+#include "latency_histogram.h"
+
+#define SUB_BUCKETS (1u << LATENCY_SUB_BUCKET_BITS)
+#define HALF_SUB_BUCKETS (SUB_BUCKETS >> 1)
+
+static size_t bucket_index(uint64_t value) {
+  if (value < SUB_BUCKETS) return (size_t) value;
+
+  unsigned int exponent = (unsigned int) (63 - __builtin_clzll(value)) - LATENCY_SUB_BUCKET_BITS + 1;
+  if (exponent > LATENCY_MAX_EXPONENT) return LATENCY_BUCKET_COUNT - 1;
+
+  return (size_t) exponent * HALF_SUB_BUCKETS + (size_t) (value >> exponent);
+}
+
+static uint64_t bucket_upper_bound(size_t index) {
+  if (index < SUB_BUCKETS) return index;
+
+  size_t exponent = index / HALF_SUB_BUCKETS - 1;
+  uint64_t sub_bucket = index - exponent * HALF_SUB_BUCKETS;
+
+  return ((sub_bucket + 1) << exponent) - 1;
+}
+
+void latency_record(LatencyHistogram *histogram, uint64_t latency_ns) {
+  uint64_t us = latency_ns / 1000;
+
+  atomic_fetch_add_explicit(&histogram->buckets[bucket_index(us)], 1, memory_order_relaxed);
+  atomic_fetch_add_explicit(&histogram->count, 1, memory_order_relaxed);
+
+  uint64_t max = atomic_load_explicit(&histogram->max_us, memory_order_relaxed);
+
+  while (us > max &&
+         !atomic_compare_exchange_weak_explicit(&histogram->max_us, &max, us, memory_order_relaxed, memory_order_relaxed));
+}
+
+void latency_reset(LatencyHistogram *histogram) {
+  for (size_t i = 0; i < LATENCY_BUCKET_COUNT; i++) atomic_store_explicit(&histogram->buckets[i], 0, memory_order_relaxed);
+
+  atomic_store_explicit(&histogram->count, 0, memory_order_relaxed);
+  atomic_store_explicit(&histogram->max_us, 0, memory_order_relaxed);
+}
+
+uint64_t latency_count(const LatencyHistogram *histogram) {
+  return atomic_load_explicit(&histogram->count, memory_order_relaxed);
+}
+
+uint64_t latency_percentile_us(const LatencyHistogram *histogram, double q) {
+  uint64_t total = latency_count(histogram);
+  if (total == 0) return 0;
+
+  uint64_t rank = (uint64_t) (q * (double) total + 0.5);
+  if (rank == 0) rank = 1;
+
+  uint64_t seen = 0;
+
+  for (size_t i = 0; i < LATENCY_BUCKET_COUNT; i++) {
+    seen += atomic_load_explicit(&histogram->buckets[i], memory_order_relaxed);
+
+    // Never report past the largest value actually seen.
+    if (seen >= rank) return MIN(bucket_upper_bound(i), atomic_load_explicit(&histogram->max_us, memory_order_relaxed));
+  }
+
+  return atomic_load_explicit(&histogram->max_us, memory_order_relaxed);
+}
+
+void latency_print(FILE *out, const char *label, const LatencyHistogram *histogram) {
+  static const double QUANTILES[] = { 0.5, 0.9, 0.99, 0.999 };
+
+  fprintf(out, "%-48s %10llu", label, (unsigned long long) latency_count(histogram));
+
+  for (size_t i = 0; i < ARRAY_SIZE(QUANTILES); i++) {
+    fprintf(out, " %10.3f", (double) latency_percentile_us(histogram, QUANTILES[i]) / 1000.0);
+  }
+
+  fprintf(out, " %10.3f\n", (double) atomic_load_explicit(&histogram->max_us, memory_order_relaxed) / 1000.0);
+}
+
+void latency_snapshot(const LatencyHistogram *histogram, LatencySnapshot *out) {
+  for (size_t i = 0; i < LATENCY_BUCKET_COUNT; i++) {
+    out->buckets[i] = atomic_load_explicit(&histogram->buckets[i], memory_order_relaxed);
+  }
+
+  out->max_us = atomic_load_explicit(&histogram->max_us, memory_order_relaxed);
+}
+
+void latency_merge(LatencyHistogram *histogram, const LatencySnapshot *snapshot) {
+  uint64_t total = 0;
+
+  for (size_t i = 0; i < LATENCY_BUCKET_COUNT; i++) {
+    if (!snapshot->buckets[i]) continue;
+
+    atomic_fetch_add_explicit(&histogram->buckets[i], snapshot->buckets[i], memory_order_relaxed);
+    total += snapshot->buckets[i];
+  }
+
+  atomic_fetch_add_explicit(&histogram->count, total, memory_order_relaxed);
+
+  uint64_t max = atomic_load_explicit(&histogram->max_us, memory_order_relaxed);
+
+  while (snapshot->max_us > max &&
+         !atomic_compare_exchange_weak_explicit(&histogram->max_us, &max, snapshot->max_us, memory_order_relaxed, memory_order_relaxed));
+}
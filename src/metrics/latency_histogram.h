@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdatomic.h>
+
+#include "../common.h"
+
+// Log-linear (HDR-style) histogram over microseconds: values below 2^5 get
+// their own bucket, and every power of two above is split into 16 linear
+// sub-buckets, so any recorded value is off by at most ~6%. Memory is fixed;
+// values beyond ~19 h land in the last bucket.
+#define LATENCY_SUB_BUCKET_BITS 5
+#define LATENCY_MAX_EXPONENT 32
+#define LATENCY_BUCKET_COUNT ((LATENCY_MAX_EXPONENT + 2) << (LATENCY_SUB_BUCKET_BITS - 1))
+
+struct latency_histogram {
+  _Atomic uint64_t buckets[LATENCY_BUCKET_COUNT];
+  _Atomic uint64_t count;
+  _Atomic uint64_t max_us;
+};
+
+typedef struct latency_histogram LatencyHistogram;
+
+// Safe to call from any thread, concurrently with readers.
+void latency_record(LatencyHistogram *histogram, uint64_t latency_ns);
+
+void latency_reset(LatencyHistogram *histogram);
+
+// Upper bound (in microseconds) of the bucket holding the q-quantile,
+// q in [0, 1]. 0 when nothing has been recorded.
+uint64_t latency_percentile_us(const LatencyHistogram *histogram, double q);
+
+uint64_t latency_count(const LatencyHistogram *histogram);
+
+// One line: count, p50/p90/p99/p99.9 and max, in milliseconds.
+void latency_print(FILE *out, const char *label, const LatencyHistogram *histogram);
+
+// Plain copy of a histogram, used to persist it and load it back.
+struct latency_snapshot {
+  uint64_t max_us;
+  uint64_t buckets[LATENCY_BUCKET_COUNT];
+};
+
+typedef struct latency_snapshot LatencySnapshot;
+
+void latency_snapshot(const LatencyHistogram *histogram, LatencySnapshot *out);
+
+// Adds the snapshot's samples on top of what the histogram already holds.
+void latency_merge(LatencyHistogram *histogram, const LatencySnapshot *snapshot);
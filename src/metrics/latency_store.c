@@ -0,0 +1,196 @@
+#include "latency_store.h"
+
+#include <stdio.h>
+
+#include "../memory/memory_management.h"
+#include "../state/state_file.h"
+#include "metrics.h"
+
+#define STORE_MAGIC "CFLH"
+#define STORE_VERSION 1
+
+typedef enum {
+  RECORD_PROVIDER,
+  RECORD_ENDPOINT,
+} record_kind_t;
+
+struct store_header {
+  char magic[4];
+  uint32_t version;
+  uint32_t bucket_count;
+  uint32_t records;
+};
+
+struct store_record {
+  uint32_t kind;
+  char key[MAX_URL_LENGTH + 1];
+  LatencySnapshot snapshot;
+};
+
+typedef struct store_header StoreHeader;
+typedef struct store_record StoreRecord;
+
+void latency_store_path(char *buffer, size_t size) { state_path(buffer, size, LATENCY_STATE_FILE); }
+
+static bool write_record(FILE *out, StoreRecord *record, record_kind_t kind, const char *key, const LatencyHistogram *h) {
+  memset(record, 0, sizeof(*record));
+
+  record->kind = kind;
+  // Keys are provider hosts and endpoint templates, both bounded by
+  // MAX_URL_LENGTH; the precision only makes that bound explicit.
+  snprintf(record->key, sizeof(record->key), "%.*s", (int) sizeof(record->key) - 1, key);
+  latency_snapshot(h, &record->snapshot);
+
+  return fwrite(record, sizeof(*record), 1, out) == 1;
+}
+
+bool latency_store_save(const char *path) {
+  char names[MAX_METRIC_PROVIDERS][MAX_URL_LENGTH + 1];
+  size_t providers = metrics_provider_names(names, MAX_METRIC_PROVIDERS);
+
+  char tmp[MAX_STRING_LENGTH];
+  snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+
+  StoreRecord *record = mm_malloc(sizeof(StoreRecord));
+  if (!record) return false;
+
+  FILE *out = fopen(tmp, "wb");
+
+  if (!out) {
+    mm_free(record);
+    return false;
+  }
+
+  StoreHeader header = { .version = STORE_VERSION, .bucket_count = LATENCY_BUCKET_COUNT, .records = (uint32_t) (providers + API_ENDPOINT_COUNT) };
+  memcpy(header.magic, STORE_MAGIC, sizeof(header.magic));
+
+  bool ok = fwrite(&header, sizeof(header), 1, out) == 1;
+
+  for (size_t i = 0; ok && i < providers; i++) {
+    ok = write_record(out, record, RECORD_PROVIDER, names[i], metrics_provider_latency(i));
+  }
+
+  for (size_t e = 0; ok && e < API_ENDPOINT_COUNT; e++) {
+    ok = write_record(out, record, RECORD_ENDPOINT, api_endpoint_template(e), metrics_endpoint_latency(e));
+  }
+
+  mm_free(record);
+
+  if (fclose(out) != 0) ok = false;
+
+  if (!ok || rename(tmp, path) != 0) {
+    remove(tmp);
+    return false;
+  }
+
+  return true;
+}
+
+static FILE *open_store(const char *path, StoreHeader *header) {
+  FILE *in = fopen(path, "rb");
+  if (!in) return NULL;
+
+  if (fread(header, sizeof(*header), 1, in) != 1 || memcmp(header->magic, STORE_MAGIC, sizeof(header->magic)) != 0 ||
+      header->version != STORE_VERSION || header->bucket_count != LATENCY_BUCKET_COUNT) {
+    fclose(in);
+    return NULL;
+  }
+
+  return in;
+}
+
+// Endpoint templates are not unique on their own (same path, different
+// methods), so endpoints are matched by position among endpoint records.
+bool latency_store_load(const char *path) {
+  StoreHeader header;
+  FILE *in = open_store(path, &header);
+  if (!in) return false;
+
+  char names[MAX_METRIC_PROVIDERS][MAX_URL_LENGTH + 1];
+  size_t providers = metrics_provider_names(names, MAX_METRIC_PROVIDERS);
+
+  StoreRecord *record = mm_malloc(sizeof(StoreRecord));
+
+  if (!record) {
+    fclose(in);
+    return false;
+  }
+
+  size_t endpoint = 0;
+  bool ok = true;
+
+  for (uint32_t r = 0; r < header.records; r++) {
+    if (fread(record, sizeof(*record), 1, in) != 1) {
+      ok = false;
+      break;
+    }
+
+    record->key[MAX_URL_LENGTH] = '\0';
+
+    if (record->kind == RECORD_ENDPOINT) {
+      if (endpoint < API_ENDPOINT_COUNT) latency_merge(metrics_endpoint_latency(endpoint), &record->snapshot);
+      endpoint++;
+      continue;
+    }
+
+    for (size_t i = 0; i < providers; i++) {
+      if (strcmp(names[i], record->key) != 0) continue;
+
+      latency_merge(metrics_provider_latency(i), &record->snapshot);
+      break;
+    }
+  }
+
+  mm_free(record);
+  fclose(in);
+
+  return ok;
+}
+
+bool latency_store_print(const char *path, FILE *out) {
+  StoreHeader header;
+  FILE *in = open_store(path, &header);
+  if (!in) return false;
+
+  StoreRecord *record = mm_malloc(sizeof(StoreRecord));
+  LatencyHistogram *histogram = mm_malloc(sizeof(LatencyHistogram));
+
+  if (!record || !histogram) {
+    mm_free(record);
+    mm_free(histogram);
+    fclose(in);
+    return false;
+  }
+
+  fprintf(out, "%-48s %10s %10s %10s %10s %10s %10s\n", "latency (ms)", "count", "p50", "p90", "p99", "p99.9", "max");
+
+  size_t endpoint = 0;
+  bool ok = true;
+
+  for (uint32_t r = 0; r < header.records; r++) {
+    if (fread(record, sizeof(*record), 1, in) != 1) {
+      ok = false;
+      break;
+    }
+
+    record->key[MAX_URL_LENGTH] = '\0';
+
+    char label[MAX_URL_LENGTH + 16];
+
+    if (record->kind == RECORD_ENDPOINT && endpoint < API_ENDPOINT_COUNT) {
+      snprintf(label, sizeof(label), "%s %s", api_endpoint_method(endpoint++), record->key);
+    } else {
+      snprintf(label, sizeof(label), "%s", record->key);
+    }
+
+    latency_reset(histogram);
+    latency_merge(histogram, &record->snapshot);
+    latency_print(out, label, histogram);
+  }
+
+  mm_free(record);
+  mm_free(histogram);
+  fclose(in);
+
+  return ok;
+}
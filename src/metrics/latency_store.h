@@ -0,0 +1,21 @@
+#pragma once
+
+#include "../common.h"
+
+// Latency histograms survive restarts in a small binary file (native byte
+// order, versioned), so percentile-driven decisions don't start cold.
+
+// $STATE_DIRECTORY/latency.hdr, or the default state directory.
+void latency_store_path(char *buffer, size_t size);
+
+// Writes every provider and endpoint histogram. The file is replaced
+// atomically (temp file + rename).
+bool latency_store_save(const char *path);
+
+// Merges the saved histograms into the live ones. Providers are matched by
+// URL, so call it after metrics_set_providers(); entries for URLs no longer
+// configured are ignored.
+bool latency_store_load(const char *path);
+
+// Prints the percentiles of every histogram in the file (CLI dump).
+bool latency_store_print(const char *path, FILE *out);
@@ -0,0 +1,335 @@
+#include "metrics.h"
+
+#include <pthread.h>
+
+#include "../tracing/probes.h"
+#include "../utils/time_utils.h"
+
+typedef enum {
+  STATUS_CLASS_2XX,
+  STATUS_CLASS_3XX,
+  STATUS_CLASS_4XX,
+  STATUS_CLASS_429,
+  STATUS_CLASS_5XX,
+  STATUS_CLASS_ERROR,  // no HTTP response at all
+  STATUS_CLASS_COUNT
+} status_class_t;
+
+static const char *STATUS_CLASS_LABELS[STATUS_CLASS_COUNT] = { "2xx", "3xx", "4xx", "429", "5xx", "error" };
+
+static const struct {
+  const char *method;
+  const char *path;
+} ENDPOINTS[API_ENDPOINT_COUNT] = {
+    [API_ENDPOINT_VERIFY_TOKEN] = { "GET", "/user/tokens/verify" },
+    [API_ENDPOINT_LIST_ZONES] = { "GET", "/zones" },
+    [API_ENDPOINT_LIST_RECORDS] = { "GET", "/zones/:zone_id/dns_records" },
+    [API_ENDPOINT_CREATE_RECORD] = { "POST", "/zones/:zone_id/dns_records" },
+    [API_ENDPOINT_UPDATE_RECORD] = { "PATCH", "/zones/:zone_id/dns_records/:record_id" },
+};
+
+static const char *CACHE_LABELS[CACHE_KIND_COUNT] = { "zone_id", "record", "public_ip" };
+
+// Upper bounds of the cycle duration histogram, in seconds.
+static const double CYCLE_BUCKETS[] = { 0.1, 0.25, 0.5, 1, 2.5, 5, 10, 30, 60 };
+
+#define CYCLE_BUCKET_COUNT ARRAY_SIZE(CYCLE_BUCKETS)
+
+struct metrics_block {
+  struct metrics_block *next;
+  _Atomic uint64_t cycle_buckets[CYCLE_BUCKET_COUNT + 1];  // last = +Inf
+  _Atomic uint64_t cycle_sum_ns;
+  _Atomic uint64_t provider_requests[MAX_METRIC_PROVIDERS];
+  _Atomic uint64_t provider_errors[MAX_METRIC_PROVIDERS];
+  _Atomic uint64_t provider_latency_ns[MAX_METRIC_PROVIDERS];
+  _Atomic uint64_t api_calls[API_ENDPOINT_COUNT][STATUS_CLASS_COUNT];
+  _Atomic uint64_t rate_limit_wait_ns;
+  _Atomic uint64_t cache_hits[CACHE_KIND_COUNT];
+  _Atomic uint64_t cache_misses[CACHE_KIND_COUNT];
+};
+
+typedef struct metrics_block MetricsBlock;
+
+// Blocks are only ever pushed (never unlinked), so the scraper can walk the
+// list without locks. A block outlives its thread: counters are monotonic.
+static _Atomic(MetricsBlock *) blocks = NULL;
+static _Thread_local MetricsBlock *t_block = NULL;
+
+// Used by threads whose own block could not be allocated.
+static MetricsBlock fallback_block;
+static atomic_flag fallback_linked = ATOMIC_FLAG_INIT;
+
+// Shared rather than per-thread: each histogram is ~4 KiB and the buckets
+// are spread out enough that writers rarely contend on the same line.
+static LatencyHistogram provider_latency[MAX_METRIC_PROVIDERS];
+static LatencyHistogram endpoint_latency[API_ENDPOINT_COUNT];
+
+static pthread_mutex_t providers_lock = PTHREAD_MUTEX_INITIALIZER;
+static char provider_names[MAX_METRIC_PROVIDERS][MAX_URL_LENGTH + 1];
+static size_t provider_count = 0;
+
+static void link_block(MetricsBlock *block) {
+  MetricsBlock *head = atomic_load_explicit(&blocks, memory_order_relaxed);
+
+  do {
+    block->next = head;
+  } while (!atomic_compare_exchange_weak_explicit(&blocks, &head, block, memory_order_release, memory_order_relaxed));
+}
+
+static MetricsBlock *thread_block(void) {
+  if (t_block) return t_block;
+
+  t_block = mm_calloc(1, sizeof(MetricsBlock));
+
+  if (t_block) {
+    link_block(t_block);
+  } else {
+    if (!atomic_flag_test_and_set(&fallback_linked)) link_block(&fallback_block);
+    t_block = &fallback_block;
+  }
+
+  return t_block;
+}
+
+static inline void add(_Atomic uint64_t *counter, uint64_t value) {
+  atomic_fetch_add_explicit(counter, value, memory_order_relaxed);
+}
+
+static status_class_t status_class(int status) {
+  if (status == 429) return STATUS_CLASS_429;
+  if (status >= 200 && status < 300) return STATUS_CLASS_2XX;
+  if (status >= 300 && status < 400) return STATUS_CLASS_3XX;
+  if (status >= 400 && status < 500) return STATUS_CLASS_4XX;
+  if (status >= 500 && status < 600) return STATUS_CLASS_5XX;
+
+  return STATUS_CLASS_ERROR;
+}
+
+const char *api_endpoint_method(api_endpoint_t endpoint) { return ENDPOINTS[endpoint].method; }
+
+const char *api_endpoint_template(api_endpoint_t endpoint) { return ENDPOINTS[endpoint].path; }
+
+void metrics_observe_cycle(uint64_t duration_ns) {
+  MetricsBlock *block = thread_block();
+  double seconds = (double) duration_ns / NS_PER_SEC;
+  size_t bucket = 0;
+
+  while (bucket < CYCLE_BUCKET_COUNT && seconds > CYCLE_BUCKETS[bucket]) bucket++;
+
+  add(&block->cycle_buckets[bucket], 1);
+  add(&block->cycle_sum_ns, duration_ns);
+}
+
+void metrics_provider_request(size_t provider, uint64_t latency_ns, bool ok) {
+  PROBE_PROVIDER_END(provider, latency_ns, ok);
+
+  if (provider >= MAX_METRIC_PROVIDERS) return;
+
+  MetricsBlock *block = thread_block();
+
+  add(&block->provider_requests[provider], 1);
+  add(&block->provider_latency_ns[provider], latency_ns);
+  if (!ok) add(&block->provider_errors[provider], 1);
+
+  latency_record(&provider_latency[provider], latency_ns);
+}
+
+void metrics_api_call(api_endpoint_t endpoint, int http_status, uint64_t latency_ns) {
+  PROBE_API_END(endpoint, http_status, latency_ns);
+
+  add(&thread_block()->api_calls[endpoint][status_class(http_status)], 1);
+
+  latency_record(&endpoint_latency[endpoint], latency_ns);
+}
+
+void metrics_rate_limit_wait(uint64_t wait_ns) {
+  add(&thread_block()->rate_limit_wait_ns, wait_ns);
+}
+
+void metrics_cache_lookup(cache_kind_t kind, bool hit) {
+  PROBE_CACHE_LOOKUP(kind, hit);
+
+  MetricsBlock *block = thread_block();
+
+  add(hit ? &block->cache_hits[kind] : &block->cache_misses[kind], 1);
+}
+
+// The counters of a provider slot live in every thread's block. An add
+// racing with the reset may survive it; a slot is only reset when its URL
+// changes, so that is at most one request credited to the new label.
+static void reset_provider(size_t provider) {
+  for (MetricsBlock *b = atomic_load_explicit(&blocks, memory_order_acquire); b; b = b->next) {
+    atomic_store_explicit(&b->provider_requests[provider], 0, memory_order_relaxed);
+    atomic_store_explicit(&b->provider_errors[provider], 0, memory_order_relaxed);
+    atomic_store_explicit(&b->provider_latency_ns[provider], 0, memory_order_relaxed);
+  }
+
+  latency_reset(&provider_latency[provider]);
+}
+
+void metrics_set_providers(char *const *urls, size_t count) {
+  pthread_mutex_lock(&providers_lock);
+
+  provider_count = MIN(count, (size_t) MAX_METRIC_PROVIDERS);
+
+  for (size_t i = 0; i < provider_count; i++) {
+    if (strncmp(provider_names[i], urls[i], MAX_URL_LENGTH) == 0) continue;
+
+    snprintf(provider_names[i], sizeof(provider_names[i]), "%s", urls[i]);
+    reset_provider(i);
+  }
+
+  pthread_mutex_unlock(&providers_lock);
+}
+
+size_t metrics_provider_names(char names[][MAX_URL_LENGTH + 1], size_t max) {
+  pthread_mutex_lock(&providers_lock);
+
+  size_t count = MIN(provider_count, max);
+  for (size_t i = 0; i < count; i++) memcpy(names[i], provider_names[i], MAX_URL_LENGTH + 1);
+
+  pthread_mutex_unlock(&providers_lock);
+
+  return count;
+}
+
+LatencyHistogram *metrics_provider_latency(size_t provider) {
+  return provider < MAX_METRIC_PROVIDERS ? &provider_latency[provider] : NULL;
+}
+
+LatencyHistogram *metrics_endpoint_latency(api_endpoint_t endpoint) { return &endpoint_latency[endpoint]; }
+
+static uint64_t sum(const _Atomic uint64_t *counter) {
+  uint64_t total = 0;
+  size_t offset = (size_t) ((const char *) counter - (const char *) &fallback_block);
+
+  for (MetricsBlock *b = atomic_load_explicit(&blocks, memory_order_acquire); b; b = b->next) {
+    total += atomic_load_explicit((const _Atomic uint64_t *) ((const char *) b + offset), memory_order_relaxed);
+  }
+
+  return total;
+}
+
+// Counters are addressed through the fallback block's layout: `sum()` reads
+// the same field in every registered block.
+#define SUM(field) sum(&fallback_block.field)
+
+static void render_cycles(FILE *out) {
+  fprintf(out, "# HELP " METRICS_PREFIX "cycle_duration_seconds Duration of update cycles.\n");
+  fprintf(out, "# TYPE " METRICS_PREFIX "cycle_duration_seconds histogram\n");
+
+  uint64_t cumulative = 0;
+
+  for (size_t i = 0; i < CYCLE_BUCKET_COUNT; i++) {
+    cumulative += SUM(cycle_buckets[i]);
+    fprintf(out, METRICS_PREFIX "cycle_duration_seconds_bucket{le=\"%g\"} %llu\n",
+            CYCLE_BUCKETS[i], (unsigned long long) cumulative);
+  }
+
+  cumulative += SUM(cycle_buckets[CYCLE_BUCKET_COUNT]);
+  fprintf(out, METRICS_PREFIX "cycle_duration_seconds_bucket{le=\"+Inf\"} %llu\n", (unsigned long long) cumulative);
+  fprintf(out, METRICS_PREFIX "cycle_duration_seconds_sum %.6f\n", (double) SUM(cycle_sum_ns) / NS_PER_SEC);
+  fprintf(out, METRICS_PREFIX "cycle_duration_seconds_count %llu\n", (unsigned long long) cumulative);
+}
+
+static void render_providers(FILE *out) {
+  pthread_mutex_lock(&providers_lock);
+
+  fprintf(out, "# HELP " METRICS_PREFIX "provider_requests_total IP provider requests.\n");
+  fprintf(out, "# TYPE " METRICS_PREFIX "provider_requests_total counter\n");
+  for (size_t i = 0; i < provider_count; i++) {
+    fprintf(out, METRICS_PREFIX "provider_requests_total{provider=\"%s\"} %llu\n",
+            provider_names[i], (unsigned long long) SUM(provider_requests[i]));
+  }
+
+  fprintf(out, "# HELP " METRICS_PREFIX "provider_errors_total Failed IP provider requests.\n");
+  fprintf(out, "# TYPE " METRICS_PREFIX "provider_errors_total counter\n");
+  for (size_t i = 0; i < provider_count; i++) {
+    fprintf(out, METRICS_PREFIX "provider_errors_total{provider=\"%s\"} %llu\n",
+            provider_names[i], (unsigned long long) SUM(provider_errors[i]));
+  }
+
+  fprintf(out, "# HELP " METRICS_PREFIX "provider_latency_seconds_total Time spent waiting on IP providers.\n");
+  fprintf(out, "# TYPE " METRICS_PREFIX "provider_latency_seconds_total counter\n");
+  for (size_t i = 0; i < provider_count; i++) {
+    fprintf(out, METRICS_PREFIX "provider_latency_seconds_total{provider=\"%s\"} %.6f\n",
+            provider_names[i], (double) SUM(provider_latency_ns[i]) / NS_PER_SEC);
+  }
+
+  pthread_mutex_unlock(&providers_lock);
+}
+
+static void render_api(FILE *out) {
+  fprintf(out, "# HELP " METRICS_PREFIX "api_calls_total Cloudflare API calls by endpoint and status class.\n");
+  fprintf(out, "# TYPE " METRICS_PREFIX "api_calls_total counter\n");
+
+  for (size_t e = 0; e < API_ENDPOINT_COUNT; e++) {
+    for (size_t c = 0; c < STATUS_CLASS_COUNT; c++) {
+      uint64_t value = SUM(api_calls[e][c]);
+      if (value == 0) continue;
+
+      fprintf(out, METRICS_PREFIX "api_calls_total{method=\"%s\",endpoint=\"%s\",status=\"%s\"} %llu\n",
+              ENDPOINTS[e].method, ENDPOINTS[e].path, STATUS_CLASS_LABELS[c], (unsigned long long) value);
+    }
+  }
+
+  fprintf(out, "# HELP " METRICS_PREFIX "rate_limit_wait_seconds_total Time spent waiting on the API rate limiter.\n");
+  fprintf(out, "# TYPE " METRICS_PREFIX "rate_limit_wait_seconds_total counter\n");
+  fprintf(out, METRICS_PREFIX "rate_limit_wait_seconds_total %.6f\n", (double) SUM(rate_limit_wait_ns) / NS_PER_SEC);
+}
+
+static void render_caches(FILE *out) {
+  fprintf(out, "# HELP " METRICS_PREFIX "cache_lookups_total Cache lookups by cache and result.\n");
+  fprintf(out, "# TYPE " METRICS_PREFIX "cache_lookups_total counter\n");
+
+  for (size_t k = 0; k < CACHE_KIND_COUNT; k++) {
+    fprintf(out, METRICS_PREFIX "cache_lookups_total{cache=\"%s\",result=\"hit\"} %llu\n",
+            CACHE_LABELS[k], (unsigned long long) SUM(cache_hits[k]));
+    fprintf(out, METRICS_PREFIX "cache_lookups_total{cache=\"%s\",result=\"miss\"} %llu\n",
+            CACHE_LABELS[k], (unsigned long long) SUM(cache_misses[k]));
+  }
+}
+
+static void render_memory(FILE *out) {
+  memory_stats_t stats;
+  memory_get_stats(&stats);
+
+  const struct {
+    const char *name;
+    const char *type;
+    size_t value;
+  } rows[] = {
+      { "memory_allocated_bytes_total", "counter", stats.total_allocated },
+      { "memory_allocated_bytes", "gauge", stats.current_allocated },
+      { "memory_peak_allocated_bytes", "gauge", stats.peak_allocated },
+      { "memory_allocations_total", "counter", stats.allocation_count },
+      { "memory_deallocations_total", "counter", stats.deallocation_count },
+      { "memory_failed_allocations_total", "counter", stats.failed_allocations },
+      { "memory_allocation_retries_total", "counter", stats.retry_count },
+  };
+
+  for (size_t i = 0; i < ARRAY_SIZE(rows); i++) {
+    fprintf(out, "# TYPE " METRICS_PREFIX "%s %s\n" METRICS_PREFIX "%s %zu\n",
+            rows[i].name, rows[i].type, rows[i].name, rows[i].value);
+  }
+}
+
+char *metrics_render(size_t *length) {
+  char *buf = NULL;
+  size_t len = 0;
+
+  FILE *out = open_memstream(&buf, &len);
+  if (!out) return NULL;
+
+  render_cycles(out);
+  render_providers(out);
+  render_api(out);
+  render_caches(out);
+  render_memory(out);
+
+  fclose(out);
+
+  if (length) *length = len;
+
+  return buf;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stdatomic.h>
+
+#include "../common.h"
+#include "../memory/memory_management.h"
+#include "latency_histogram.h"
+
+#define MAX_METRIC_PROVIDERS 16
+#define METRICS_PREFIX "cfddns_"
+
+typedef enum {
+  API_ENDPOINT_VERIFY_TOKEN,
+  API_ENDPOINT_LIST_ZONES,
+  API_ENDPOINT_LIST_RECORDS,
+  API_ENDPOINT_CREATE_RECORD,
+  API_ENDPOINT_UPDATE_RECORD,
+  API_ENDPOINT_COUNT
+} api_endpoint_t;
+
+typedef enum {
+  CACHE_ZONE_ID,
+  CACHE_RECORD,
+  CACHE_PUBLIC_IP,
+  CACHE_KIND_COUNT
+} cache_kind_t;
+
+// Method and path template of each endpoint (labels, never real IDs).
+const char *api_endpoint_method(api_endpoint_t endpoint);
+
+const char *api_endpoint_template(api_endpoint_t endpoint);
+
+// Hot-path recorders. Each one only does relaxed atomic adds on the calling
+// thread's own counter block; blocks are summed when metrics are scraped.
+void metrics_observe_cycle(uint64_t duration_ns);
+
+void metrics_provider_request(size_t provider, uint64_t latency_ns, bool ok);
+
+void metrics_api_call(api_endpoint_t endpoint, int http_status, uint64_t latency_ns);
+
+void metrics_rate_limit_wait(uint64_t wait_ns);
+
+void metrics_cache_lookup(cache_kind_t kind, bool hit);
+
+// Label values for provider indexes (copied; call again after a reload).
+// An index whose URL changes starts over: its request, error and latency
+// counters and its latency histogram are zeroed.
+void metrics_set_providers(char *const *urls, size_t count);
+
+// Copies the current provider URLs into `names`; returns how many.
+size_t metrics_provider_names(char names[][MAX_URL_LENGTH + 1], size_t max);
+
+// Latency distributions, fed by metrics_provider_request() and
+// metrics_api_call(). Readable at any time (e.g. to pick hedging delays).
+LatencyHistogram *metrics_provider_latency(size_t provider);
+
+LatencyHistogram *metrics_endpoint_latency(api_endpoint_t endpoint);
+
+// Prometheus text exposition format (0.0.4). Returns a heap buffer the
+// caller releases with free(), or NULL.
+char *metrics_render(size_t *length);
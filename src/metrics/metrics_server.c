@@ -0,0 +1,283 @@
+#define _GNU_SOURCE  // accept4
+
+#include "metrics_server.h"
+
+#include <errno.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "../daemon/daemon.h"
+#include "../memory/memory_management.h"
+#include "../utils/time_utils.h"
+#include "metrics.h"
+
+#define METRICS_BACKLOG 8
+
+struct metrics_client {
+  EventSource source;
+  MetricsServer *server;
+  struct metrics_client *prev;
+  struct metrics_client *next;
+  WheelTimer timeout;
+
+  char *response;  // NULL while the request is still being read
+  size_t length;
+  size_t sent;
+
+  size_t used;
+  char request[METRICS_MAX_REQUEST_SIZE];
+};
+
+typedef struct metrics_client MetricsClient;
+
+static const char RESPONSE_HEADER[] =
+    "HTTP/1.0 200 OK\r\n"
+    "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+    "Content-Length: %zu\r\n"
+    "Connection: close\r\n\r\n";
+
+static const char RESPONSE_ERROR[] =
+    "HTTP/1.0 500 Internal Server Error\r\n"
+    "Content-Length: 0\r\n"
+    "Connection: close\r\n\r\n";
+
+static int listen_unix(MetricsServer *server, const char *path) {
+  struct sockaddr_un addr = { .sun_family = AF_UNIX };
+
+  if (strlen(path) >= sizeof(addr.sun_path)) return -1;
+  strcpy(addr.sun_path, path);
+
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd < 0) return -1;
+
+  // A socket left behind by a previous run would make bind() fail.
+  unlink(path);
+
+  if (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) != 0 || listen(fd, METRICS_BACKLOG) != 0) {
+    close(fd);
+    return -1;
+  }
+
+  snprintf(server->path, sizeof(server->path), "%s", path);
+
+  return fd;
+}
+
+static int listen_tcp(const char *address) {
+  const char *colon = strrchr(address, ':');
+  if (!colon || (size_t) (colon - address) > MAX_URL_LENGTH) return -1;
+
+  char host[MAX_URL_LENGTH + 1];
+  size_t host_len = (size_t) (colon - address);
+
+  memcpy(host, address, host_len);
+  host[host_len] = '\0';
+
+  struct addrinfo hints = { .ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM, .ai_flags = AI_PASSIVE };
+  struct addrinfo *list = NULL;
+
+  if (getaddrinfo(host_len ? host : NULL, colon + 1, &hints, &list) != 0) return -1;
+
+  int fd = -1;
+
+  for (struct addrinfo *ai = list; ai && fd < 0; ai = ai->ai_next) {
+    fd = socket(ai->ai_family, ai->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, ai->ai_protocol);
+    if (fd < 0) continue;
+
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    if (bind(fd, ai->ai_addr, ai->ai_addrlen) != 0 || listen(fd, METRICS_BACKLOG) != 0) {
+      close(fd);
+      fd = -1;
+    }
+  }
+
+  freeaddrinfo(list);
+
+  return fd;
+}
+
+static void close_client(MetricsClient *client) {
+  MetricsServer *server = client->server;
+
+  if (client->prev) {
+    client->prev->next = client->next;
+  } else {
+    server->clients = client->next;
+  }
+
+  if (client->next) client->next->prev = client->prev;
+  server->client_count--;
+
+  daemon_timer_cancel(&client->timeout);
+  event_loop_remove(server->loop, &client->source);
+  close(client->source.fd);
+  free(client->response);
+  mm_free(client);
+}
+
+// Builds the whole answer up front; it is then written out as the socket
+// accepts it.
+static bool prepare_response(MetricsClient *client) {
+  size_t length = 0;
+  char *body = metrics_render(&length);
+  char header[sizeof(RESPONSE_HEADER) + 24];
+  int header_len = body ? snprintf(header, sizeof(header), RESPONSE_HEADER, length) : 0;
+
+  client->response = body ? malloc((size_t) header_len + length) : NULL;
+
+  if (client->response) {
+    memcpy(client->response, header, (size_t) header_len);
+    memcpy(client->response + header_len, body, length);
+    client->length = (size_t) header_len + length;
+  } else {
+    client->response = malloc(sizeof(RESPONSE_ERROR) - 1);
+    if (!client->response) {
+      free(body);
+      return false;
+    }
+
+    memcpy(client->response, RESPONSE_ERROR, sizeof(RESPONSE_ERROR) - 1);
+    client->length = sizeof(RESPONSE_ERROR) - 1;
+  }
+
+  free(body);
+
+  return true;
+}
+
+// False once the connection is finished (fully sent or failed).
+static bool send_pending(MetricsClient *client) {
+  while (client->sent < client->length) {
+    ssize_t n = send(client->source.fd, client->response + client->sent, client->length - client->sent, MSG_NOSIGNAL);
+
+    if (n < 0) return errno == EAGAIN || errno == EINTR;
+
+    client->sent += (size_t) n;
+  }
+
+  return false;
+}
+
+// The request itself is irrelevant (every path serves the metrics), but it
+// is read up to the end of the headers so the client sees a clean close.
+static bool read_request(MetricsClient *client) {
+  for (;;) {
+    ssize_t n = recv(client->source.fd, client->request + client->used, sizeof(client->request) - 1 - client->used, 0);
+
+    if (n < 0) return errno != EAGAIN && errno != EINTR;
+    if (n == 0) return true;
+
+    client->used += (size_t) n;
+    client->request[client->used] = '\0';
+
+    if (strstr(client->request, "\r\n\r\n") || strstr(client->request, "\n\n")) return true;
+    if (client->used == sizeof(client->request) - 1) return true;
+  }
+}
+
+static void on_client(EventSource *source, uint32_t events) {
+  MetricsClient *client = source->ctx;
+
+  if (!client->response) {
+    if (!read_request(client)) {
+      if (events & (EPOLLERR | EPOLLHUP)) close_client(client);
+      return;
+    }
+
+    if (!prepare_response(client)) {
+      close_client(client);
+      return;
+    }
+
+    // Usually the whole answer fits in the socket buffer right away.
+    if (send_pending(client) && event_loop_modify(client->server->loop, source, EPOLLOUT)) return;
+
+    close_client(client);
+    return;
+  }
+
+  if (!send_pending(client) || (events & EPOLLERR)) close_client(client);
+}
+
+static void on_timeout(WheelTimer *timer) { close_client(timer->ctx); }
+
+static void on_accept(EventSource *source, uint32_t events) {
+  (void) events;
+  MetricsServer *server = source->ctx;
+  int fd;
+
+  while ((fd = accept4(source->fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+    // At the limit the oldest connection makes room, so idle scrapers cannot
+    // pile up descriptors.
+    if (server->client_count >= METRICS_MAX_CLIENTS) close_client(server->clients);
+
+    MetricsClient *client = mm_calloc(1, sizeof(MetricsClient));
+
+    if (!client) {
+      close(fd);
+      return;
+    }
+
+    client->server = server;
+    client->timeout = (WheelTimer) { .callback = on_timeout, .ctx = client };
+    client->source = (EventSource) { .fd = fd, .handler = on_client, .ctx = client };
+
+    if (!event_loop_add(server->loop, &client->source, EPOLLIN | EPOLLRDHUP)) {
+      close(fd);
+      mm_free(client);
+      continue;
+    }
+
+    daemon_timer_schedule(&client->timeout, METRICS_CLIENT_TIMEOUT_MS * NS_PER_MS);
+
+    // Appended, so the list stays oldest first.
+    MetricsClient **tail = &server->clients;
+    MetricsClient *prev = NULL;
+
+    while (*tail) {
+      prev = *tail;
+      tail = &prev->next;
+    }
+
+    client->prev = prev;
+    *tail = client;
+    server->client_count++;
+  }
+}
+
+bool metrics_server_open(MetricsServer *server, EventLoop *loop, const char *address) {
+  size_t prefix_len = strlen(METRICS_UNIX_PREFIX);
+
+  *server = (MetricsServer) { .loop = loop, .listener = { .fd = -1, .handler = on_accept, .ctx = server } };
+
+  int fd = strncmp(address, METRICS_UNIX_PREFIX, prefix_len) == 0 ? listen_unix(server, address + prefix_len)
+                                                                  : listen_tcp(address);
+  if (fd < 0) return false;
+
+  server->listener.fd = fd;
+
+  if (!event_loop_add(loop, &server->listener, EPOLLIN)) {
+    metrics_server_close(server);
+    return false;
+  }
+
+  return true;
+}
+
+void metrics_server_close(MetricsServer *server) {
+  while (server->clients) close_client(server->clients);
+
+  if (server->listener.fd >= 0) {
+    event_loop_remove(server->loop, &server->listener);
+    close(server->listener.fd);
+    server->listener.fd = -1;
+  }
+
+  if (server->path[0]) {
+    unlink(server->path);
+    server->path[0] = '\0';
+  }
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <sys/un.h>
+
+#include "../common.h"
+#include "../daemon/event_loop.h"
+
+// Prometheus scrape endpoint on "unix:/path" or "host:port", served from the
+// daemon's event loop. Connections are non-blocking and advance only when
+// epoll reports them ready, so a slow or stalled scraper never holds the
+// loop. Each connection is dropped METRICS_CLIENT_TIMEOUT_MS after it was
+// accepted (a timer on the daemon's wheel), and at most METRICS_MAX_CLIENTS
+// are kept open: the oldest makes room for a new one.
+struct metrics_client;
+
+struct metrics_server {
+  EventLoop *loop;
+  EventSource listener;
+  struct metrics_client *clients;  // oldest first
+  size_t client_count;
+  char path[sizeof(((struct sockaddr_un *) 0)->sun_path)];  // "" for TCP
+};
+
+typedef struct metrics_server MetricsServer;
+
+// Binds `address` and registers it with `loop`.
+bool metrics_server_open(MetricsServer *server, EventLoop *loop, const char *address);
+
+// Drops any scrape still in progress and removes a Unix socket file.
+void metrics_server_close(MetricsServer *server);
@@ -0,0 +1,121 @@
+#include "signal_processing.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <sys/signalfd.h>
+#include <unistd.h>
+
+static const int HANDLED_SIGNALS[] = { SIGINT, SIGTERM, SIGHUP, SIGQUIT, SIGPIPE };
+
+// SIGPIPE is not routed through the signalfd: it is simply ignored.
+static const int FD_SIGNALS[] = { SIGINT, SIGTERM, SIGHUP, SIGQUIT };
+
+static struct {
+  bool initialized;
+  struct sigaction old_handlers[ARRAY_SIZE(HANDLED_SIGNALS)];
+} signals_state = { .initialized = false };
+
+static volatile sig_atomic_t reload_pending = 0;
+static volatile sig_atomic_t termination_pending = 0;
+static volatile sig_atomic_t termination_count = 0;
+
+static void signal_handler(int signum) {
+  switch (signum) {
+    case SIGHUP:
+      reload_pending = 1;
+      break;
+
+    case SIGPIPE:
+      break;
+
+    default:
+      termination_pending = 1;
+      termination_count++;
+      break;
+  }
+}
+
+int signals_init(void) {
+  if (signals_state.initialized) return 0;
+
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = signal_handler;
+  sigemptyset(&sa.sa_mask);
+  sa.sa_flags = SA_RESTART;
+
+  for (size_t i = 0; i < ARRAY_SIZE(HANDLED_SIGNALS); i++) {
+    if (sigaction(HANDLED_SIGNALS[i], &sa, &signals_state.old_handlers[i]) != 0) return -1;
+  }
+
+  signals_state.initialized = true;
+
+  return 0;
+}
+
+void signals_cleanup(void) {
+  if (!signals_state.initialized) return;
+
+  for (size_t i = 0; i < ARRAY_SIZE(HANDLED_SIGNALS); i++) {
+    sigaction(HANDLED_SIGNALS[i], &signals_state.old_handlers[i], NULL);
+  }
+
+  signals_state.initialized = false;
+}
+
+static void fd_signal_set(sigset_t *set) {
+  sigemptyset(set);
+  for (size_t i = 0; i < ARRAY_SIZE(FD_SIGNALS); i++) sigaddset(set, FD_SIGNALS[i]);
+}
+
+int signals_open_fd(void) {
+  sigset_t set;
+  fd_signal_set(&set);
+
+  signal(SIGPIPE, SIG_IGN);
+
+  if (pthread_sigmask(SIG_BLOCK, &set, NULL) != 0) return -1;
+
+  return signalfd(-1, &set, SFD_NONBLOCK | SFD_CLOEXEC);
+}
+
+void signals_read_fd(int fd) {
+  struct signalfd_siginfo info;
+
+  for (;;) {
+    ssize_t n = read(fd, &info, sizeof(info));
+
+    if (n == (ssize_t) sizeof(info)) {
+      signal_handler((int) info.ssi_signo);
+    } else if (n < 0 && errno == EINTR) {
+      continue;
+    } else {
+      break;
+    }
+  }
+}
+
+void signals_close_fd(int fd) {
+  sigset_t set;
+  fd_signal_set(&set);
+
+  if (fd >= 0) close(fd);
+
+  pthread_sigmask(SIG_UNBLOCK, &set, NULL);
+}
+
+bool signals_take_reload(void) {
+  if (!reload_pending) return false;
+
+  reload_pending = 0;
+
+  return true;
+}
+
+bool signals_termination_requested(void) {
+  return termination_pending != 0;
+}
+
+unsigned int signals_termination_count(void) {
+  return (unsigned int) termination_count;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <signal.h>
+#include <stdbool.h>
+
+#include "../common.h"
+
+// Handlers only record what arrived; the daemon loop acts on it outside of
+// signal context. SIGHUP requests a config reload, SIGINT/SIGTERM/SIGQUIT a
+// shutdown and SIGPIPE is ignored.
+
+int signals_init(void);
+
+void signals_cleanup(void);
+
+// Returns true once per delivered SIGHUP (multiple SIGHUPs coalesce).
+bool signals_take_reload(void);
+
+// Event-loop alternative to signals_init(): blocks the handled signals for
+// the calling thread (and every thread it creates afterwards, so call it
+// before spawning any) and returns a non-blocking signalfd for them, or -1.
+int signals_open_fd(void);
+
+// Drains the signalfd and records what arrived, exactly like the handlers.
+void signals_read_fd(int fd);
+
+void signals_close_fd(int fd);
+
+bool signals_termination_requested(void);
+
+// Termination signals received so far (to tell a repeated one apart).
+unsigned int signals_termination_count(void);
@@ -0,0 +1,185 @@
+#include "state_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define FILE_SIZE (sizeof(StateFileHeader) + STATE_FILE_CAPACITY * sizeof(StateFileRecord))
+
+void state_path(char *buffer, size_t size, const char *name) {
+  const char *dir = getenv(STATE_DIRECTORY_ENV_VAR);
+
+  // systemd may hand over several directories separated by ':'.
+  if (!dir || *dir == '\0') dir = DEFAULT_STATE_DIRECTORY;
+
+  snprintf(buffer, size, "%.*s/%s", (int) strcspn(dir, ":"), dir, name);
+}
+
+static bool header_valid(const StateFileHeader *header) {
+  return memcmp(header->magic, STATE_FILE_MAGIC, sizeof(header->magic)) == 0 &&
+         header->version == STATE_FILE_VERSION && header->capacity == STATE_FILE_CAPACITY &&
+         header->count <= STATE_FILE_CAPACITY && !header->dirty;
+}
+
+static bool map(StateFile *state, const char *path, bool writable) {
+  int fd = open(path, writable ? O_RDWR | O_CREAT | O_CLOEXEC : O_RDONLY | O_CLOEXEC, 0600);
+  if (fd < 0) return false;
+
+  struct stat st;
+  bool sized = fstat(fd, &st) == 0 && (size_t) st.st_size == FILE_SIZE;
+
+  // Any other size is a different layout: start over.
+  if (!sized && writable) sized = ftruncate(fd, 0) == 0 && ftruncate(fd, FILE_SIZE) == 0;
+
+  void *data = sized ? mmap(NULL, FILE_SIZE, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0)
+                     : MAP_FAILED;
+
+  close(fd);
+
+  if (data == MAP_FAILED) return false;
+
+  state->header = data;
+  state->records = (StateFileRecord *) ((char *) data + sizeof(StateFileHeader));
+
+  return true;
+}
+
+bool state_file_open(StateFile *state, const char *path) {
+  if (!map(state, path, true)) {
+    *state = (StateFile) { .header = NULL };
+    return false;
+  }
+
+  if (!header_valid(state->header)) {
+    memset(state->header, 0, FILE_SIZE);
+    memcpy(state->header->magic, STATE_FILE_MAGIC, sizeof(state->header->magic));
+    state->header->version = STATE_FILE_VERSION;
+    state->header->capacity = STATE_FILE_CAPACITY;
+  }
+
+  return true;
+}
+
+void state_file_close(StateFile *state) {
+  if (state->header) munmap(state->header, FILE_SIZE);
+
+  state->header = NULL;
+  state->records = NULL;
+}
+
+const StateFileRecord *state_file_find(const StateFile *state, const char *name) {
+  if (!state->header) return NULL;
+
+  for (uint32_t i = 0; i < state->header->count; i++) {
+    if (strcmp(state->records[i].name, name) == 0) return &state->records[i];
+  }
+
+  return NULL;
+}
+
+bool state_file_fresh(const StateFile *state, unsigned int max_age_s) {
+  const StateFileHeader *header = state->header;
+  uint64_t now = (uint64_t) time(NULL);
+
+  if (!header || max_age_s == 0 || header->last_success_at == 0) return false;
+
+  return now >= header->last_success_at && now - header->last_success_at <= max_age_s;
+}
+
+void state_file_begin(StateFile *state) {
+  if (!state->header || state->header->dirty) return;
+
+  // On disk before any record changes, so a crash mid-update is detected.
+  state->header->dirty = 1;
+  msync(state->header, sizeof(StateFileHeader), MS_SYNC);
+}
+
+void state_file_set_detected(StateFile *state, const char *ip) {
+  if (!state->header) return;
+
+  snprintf(state->header->detected_ip, sizeof(state->header->detected_ip), "%s", ip);
+  state->header->detected_at = (uint64_t) time(NULL);
+}
+
+bool state_file_set_record(StateFile *state, const char *name, const char *zone_id, const char *record_id,
+                           const char *content) {
+  if (!state->header) return false;
+
+  StateFileRecord *record = (StateFileRecord *) state_file_find(state, name);
+
+  if (!record) {
+    if (state->header->count == STATE_FILE_CAPACITY) return false;
+
+    record = &state->records[state->header->count++];
+    snprintf(record->name, sizeof(record->name), "%s", name);
+  }
+
+  content = content ? content : "";
+  record_id = record_id ? record_id : "";
+
+  // pushed_at tracks the content, not every save.
+  if (strcmp(record->content, content) != 0 || strcmp(record->record_id, record_id) != 0) {
+    record->pushed_at = *content ? (uint64_t) time(NULL) : 0;
+  }
+
+  snprintf(record->zone_id, sizeof(record->zone_id), "%s", zone_id ? zone_id : "");
+  snprintf(record->record_id, sizeof(record->record_id), "%s", record_id);
+  snprintf(record->content, sizeof(record->content), "%s", content);
+
+  return true;
+}
+
+static int compare_name(const void *key, const void *item) { return strcmp(key, *(char *const *) item); }
+
+void state_file_retain(StateFile *state, char *const *sorted_names, size_t count) {
+  if (!state->header) return;
+
+  uint32_t kept = 0;
+
+  for (uint32_t i = 0; i < state->header->count; i++) {
+    if (!bsearch(state->records[i].name, sorted_names, count, sizeof(char *), compare_name)) continue;
+
+    if (kept != i) state->records[kept] = state->records[i];
+    kept++;
+  }
+
+  state->header->count = kept;
+}
+
+void state_file_commit(StateFile *state, bool success) {
+  if (!state->header) return;
+
+  if (success) state->header->last_success_at = (uint64_t) time(NULL);
+
+  msync(state->header, FILE_SIZE, MS_SYNC);
+  state->header->dirty = 0;
+  msync(state->header, sizeof(StateFileHeader), MS_SYNC);
+}
+
+bool state_file_print(const char *path, FILE *out) {
+  StateFile state;
+
+  if (!map(&state, path, false)) return false;
+
+  const StateFileHeader *header = state.header;
+  bool valid = header_valid(header);
+
+  if (valid) {
+    fprintf(out, "detected_ip %s\n", *header->detected_ip ? header->detected_ip : "-");
+    fprintf(out, "detected_at %llu\n", (unsigned long long) header->detected_at);
+    fprintf(out, "last_success_at %llu\n", (unsigned long long) header->last_success_at);
+
+    for (uint32_t i = 0; i < header->count; i++) {
+      const StateFileRecord *r = &state.records[i];
+
+      fprintf(out, "record %s zone=%s id=%s content=%s pushed_at=%llu\n", r->name, *r->zone_id ? r->zone_id : "-",
+              *r->record_id ? r->record_id : "-", *r->content ? r->content : "-", (unsigned long long) r->pushed_at);
+    }
+  }
+
+  state_file_close(&state);
+
+  return valid;
+}
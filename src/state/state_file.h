@@ -0,0 +1,77 @@
+#pragma once
+
+#include "../common.h"
+
+// Update state that survives restarts, in a fixed-layout binary file (native
+// byte order, versioned) mapped MAP_SHARED: reading it costs no parsing and
+// no read(2), only page faults on first touch.
+//
+// The daemon restores its domain cache from it on startup (when fresh
+// enough) and stores what each cycle pushed between state_file_begin() and
+// state_file_commit(). An update interrupted before the commit leaves the
+// file marked dirty, and a dirty file is discarded on the next open.
+#define STATE_FILE_MAGIC "CFST"
+#define STATE_FILE_VERSION 1
+#define STATE_FILE_CAPACITY MAX_ARRAY_SIZE
+
+struct state_file_header {
+  char magic[4];
+  uint32_t version;
+  uint32_t capacity;
+  uint32_t count;
+  uint32_t dirty;
+  uint32_t reserved;
+  uint64_t detected_at;      // unix seconds
+  uint64_t last_success_at;  // unix seconds, 0 = never
+  char detected_ip[IPV4_STRING_SIZE];
+};
+
+struct state_file_record {
+  char name[MAX_URL_LENGTH + 1];
+  char zone_id[STATE_ID_SIZE];
+  char record_id[STATE_ID_SIZE];
+  char content[IPV4_STRING_SIZE];
+  uint64_t pushed_at;  // unix seconds
+};
+
+typedef struct state_file_header StateFileHeader;
+typedef struct state_file_record StateFileRecord;
+
+struct state_file {
+  StateFileHeader *header;  // NULL = not open
+  StateFileRecord *records;
+};
+
+typedef struct state_file StateFile;
+
+// $STATE_DIRECTORY/<name>, or the default state directory.
+void state_path(char *buffer, size_t size, const char *name);
+
+// Maps `path`, creating it if needed. A file with another version, size or
+// left dirty starts over empty.
+bool state_file_open(StateFile *state, const char *path);
+
+void state_file_close(StateFile *state);
+
+const StateFileRecord *state_file_find(const StateFile *state, const char *name);
+
+// True if the last successful update is at most `max_age_s` old (0 = never).
+bool state_file_fresh(const StateFile *state, unsigned int max_age_s);
+
+void state_file_begin(StateFile *state);
+
+void state_file_set_detected(StateFile *state, const char *ip);
+
+// Inserts or replaces the record for `name`. False when the file is full.
+bool state_file_set_record(StateFile *state, const char *name, const char *zone_id, const char *record_id,
+                           const char *content);
+
+// Drops records for domains no longer in `names` (sorted).
+void state_file_retain(StateFile *state, char *const *sorted_names, size_t count);
+
+// Marks the state consistent and flushes it. `success` also stamps the last
+// successful update time.
+void state_file_commit(StateFile *state, bool success);
+
+// Human-readable dump (CLI).
+bool state_file_print(const char *path, FILE *out);
@@ -0,0 +1,40 @@
+#pragma once
+
+// USDT probes (provider "cfddns"). They cost a single nop until a tracer
+// attaches, so they stay enabled in release builds:
+//
+//   bpftrace -l 'usdt:./cloudflare-ddns:cfddns:*'
+//   bpftrace -e 'usdt:./cloudflare-ddns:cfddns:api_end { @[arg1] = count(); }'
+//
+// Builds without <sys/sdt.h> (systemtap-sdt-dev) or with -DDISABLE_USDT get
+// no-op macros.
+#if !defined(DISABLE_USDT) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define HAVE_USDT 1
+#endif
+#endif
+
+#ifdef HAVE_USDT
+#define PROBE(name, ...) STAP_PROBEV(cfddns, name, ##__VA_ARGS__)
+#else
+// Arguments are only named, never evaluated, so values computed just for a
+// probe do not trigger unused-variable warnings.
+static inline int probe_unused_(int unused, ...) { return unused; }
+#define PROBE(name, ...) ((void) sizeof(probe_unused_(0, ##__VA_ARGS__)))
+#endif
+
+// Public IP providers; `provider` is the index used by the metrics module.
+// Fired around the reachability probes and by metrics_provider_request().
+#define PROBE_PROVIDER_START(provider, url) PROBE(provider_start, provider, url)
+#define PROBE_PROVIDER_END(provider, latency_ns, ok) PROBE(provider_end, provider, latency_ns, ok)
+
+// Cloudflare API; `status` is the HTTP status, or 0 when none was received.
+#define PROBE_API_END(endpoint, status, latency_ns) PROBE(api_end, endpoint, status, latency_ns)
+
+#define PROBE_CACHE_LOOKUP(kind, hit) PROBE(cache_lookup, kind, hit)
+
+#define PROBE_ALLOC_FAILURE(size) PROBE(alloc_failure, size)
+
+#define PROBE_CYCLE_START(cycle) PROBE(cycle_start, cycle)
+#define PROBE_CYCLE_END(cycle, duration_ns) PROBE(cycle_end, cycle, duration_ns)
@@ -0,0 +1,150 @@
+#include "trace.h"
+
+static const char *PHASE_NAMES[TRACE_PHASE_COUNT] = {
+#define TRACE_PHASE(id, name) [id] = name,
+#include "trace_phases.def"
+#undef TRACE_PHASE
+};
+
+const char *trace_phase_name(trace_phase_t phase) { return PHASE_NAMES[phase]; }
+
+#ifdef ENABLE_TRACING
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "../memory/memory_management.h"
+#include "../utils/time_utils.h"
+
+struct trace_event {
+  uint64_t start_ns;
+  uint64_t end_ns;
+  trace_phase_t phase;
+};
+
+typedef struct trace_event TraceEvent;
+
+// Single writer (the owning thread). `head` counts every span ever written;
+// slot head % capacity is filled before head is published. Buffers are
+// never freed: one left by an exited thread keeps its spans for the next
+// dump until a new thread takes it over.
+struct trace_buffer {
+  struct trace_buffer *next;
+  atomic_bool owned;
+  long tid;
+  _Atomic uint64_t head;
+  TraceEvent events[TRACE_BUFFER_CAPACITY];
+};
+
+typedef struct trace_buffer TraceBuffer;
+
+static _Atomic(TraceBuffer *) buffers = NULL;
+static _Thread_local TraceBuffer *t_buffer = NULL;
+static _Thread_local bool t_unavailable = false;
+static pthread_key_t exit_key;
+static pthread_once_t exit_key_once = PTHREAD_ONCE_INIT;
+static bool exit_key_ready = false;
+
+// Runs when a thread that traced exits: its buffer goes back to the pool.
+static void release_buffer(void *buffer) {
+  atomic_store_explicit(&((TraceBuffer *) buffer)->owned, false, memory_order_release);
+}
+
+static void create_exit_key(void) { exit_key_ready = pthread_key_create(&exit_key, release_buffer) == 0; }
+
+// A buffer released by an exited thread, or NULL.
+static TraceBuffer *claim_released(void) {
+  for (TraceBuffer *b = atomic_load_explicit(&buffers, memory_order_acquire); b; b = b->next) {
+    bool owned = false;
+
+    if (atomic_compare_exchange_strong_explicit(&b->owned, &owned, true, memory_order_acquire, memory_order_relaxed)) {
+      atomic_store_explicit(&b->head, 0, memory_order_relaxed);
+      return b;
+    }
+  }
+
+  return NULL;
+}
+
+static TraceBuffer *thread_buffer(void) {
+  if (t_buffer || t_unavailable) return t_buffer;
+
+  pthread_once(&exit_key_once, create_exit_key);
+
+  t_buffer = claim_released();
+
+  if (!t_buffer) {
+    t_buffer = mm_calloc(1, sizeof(TraceBuffer));
+
+    if (!t_buffer) {
+      // Tracing is best effort: don't retry (and fail) on every span.
+      t_unavailable = true;
+      return NULL;
+    }
+
+    atomic_init(&t_buffer->owned, true);
+
+    TraceBuffer *head = atomic_load_explicit(&buffers, memory_order_relaxed);
+
+    do {
+      t_buffer->next = head;
+    } while (!atomic_compare_exchange_weak_explicit(&buffers, &head, t_buffer, memory_order_release, memory_order_relaxed));
+  }
+
+  t_buffer->tid = (long) syscall(SYS_gettid);
+  // Without the key the buffer simply stays with this thread.
+  if (exit_key_ready) pthread_setspecific(exit_key, t_buffer);
+
+  return t_buffer;
+}
+
+TraceSpan trace_span_begin(trace_phase_t phase) {
+  TraceSpan span = { .phase = phase, .start_ns = monotonic_ns() };
+  return span;
+}
+
+void trace_span_end(const TraceSpan *span) {
+  uint64_t end_ns = monotonic_ns();
+  TraceBuffer *buffer = thread_buffer();
+  if (!buffer) return;
+
+  uint64_t head = atomic_load_explicit(&buffer->head, memory_order_relaxed);
+  TraceEvent *event = &buffer->events[head % TRACE_BUFFER_CAPACITY];
+
+  event->start_ns = span->start_ns;
+  event->end_ns = end_ns;
+  event->phase = span->phase;
+
+  atomic_store_explicit(&buffer->head, head + 1, memory_order_release);
+}
+
+// A span overwritten while the dump copies it may come out torn; dumps are
+// a debugging aid, so that is accepted rather than slowing down writers.
+bool trace_dump(FILE *out) {
+  long pid = (long) getpid();
+  bool first = true;
+
+  fputs("{\"traceEvents\":[", out);
+
+  for (TraceBuffer *b = atomic_load_explicit(&buffers, memory_order_acquire); b; b = b->next) {
+    uint64_t head = atomic_load_explicit(&b->head, memory_order_acquire);
+    uint64_t start = head > TRACE_BUFFER_CAPACITY ? head - TRACE_BUFFER_CAPACITY : 0;
+
+    for (uint64_t i = start; i < head; i++) {
+      const TraceEvent *e = &b->events[i % TRACE_BUFFER_CAPACITY];
+
+      fprintf(out, "%s\n{\"name\":\"%s\",\"cat\":\"phase\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%ld,\"tid\":%ld}",
+              first ? "" : ",", PHASE_NAMES[e->phase], (double) e->start_ns / 1000.0,
+              (double) (e->end_ns - e->start_ns) / 1000.0, pid, b->tid);
+      first = false;
+    }
+  }
+
+  fputs("\n],\"displayTimeUnit\":\"ms\"}\n", out);
+
+  return !ferror(out);
+}
+
+#endif
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "../common.h"
+
+typedef enum {
+#define TRACE_PHASE(id, name) id,
+#include "trace_phases.def"
+#undef TRACE_PHASE
+  TRACE_PHASE_COUNT
+} trace_phase_t;
+
+const char *trace_phase_name(trace_phase_t phase);
+
+// Spans only exist in builds with -DENABLE_TRACING. Otherwise the macros
+// expand to nothing and no clock is ever read.
+//
+//   TRACE_BEGIN(span, TRACE_CONNECT);
+//   connect(...);
+//   TRACE_END(span);
+#ifdef ENABLE_TRACING
+
+#define TRACE_BUFFER_CAPACITY 4096
+
+struct trace_span {
+  trace_phase_t phase;
+  uint64_t start_ns;
+};
+
+typedef struct trace_span TraceSpan;
+
+TraceSpan trace_span_begin(trace_phase_t phase);
+
+void trace_span_end(const TraceSpan *span);
+
+// Writes every buffered span as Chrome `trace_event` JSON (load it in
+// chrome://tracing or Perfetto). Each thread keeps its last
+// TRACE_BUFFER_CAPACITY spans. A running daemon dumps them on the control
+// socket's dump-trace command.
+bool trace_dump(FILE *out);
+
+#define TRACE_BEGIN(var, phase) TraceSpan var = trace_span_begin(phase)
+#define TRACE_END(var) trace_span_end(&(var))
+
+#else
+
+#define TRACE_BEGIN(var, phase) ((void) 0)
+#define TRACE_END(var) ((void) 0)
+
+static inline bool trace_dump(FILE *out) {
+  (void) out;
+  return false;
+}
+
+#endif
@@ -0,0 +1,20 @@
+#include "string_utils.h"
+
+const char *str_trim(const char *str, size_t *len) {
+  while (isspace((unsigned char) *str)) str++;
+
+  size_t n = strlen(str);
+  while (n > 0 && isspace((unsigned char) str[n - 1])) n--;
+
+  *len = n;
+
+  return str;
+}
+
+bool str_equals_ignore_case(const char *str, size_t len, const char *word) {
+  for (size_t i = 0; i < len; i++) {
+    if (word[i] == '\0' || tolower((unsigned char) str[i]) != tolower((unsigned char) word[i])) return false;
+  }
+
+  return word[len] == '\0';
+}
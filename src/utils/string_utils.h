@@ -0,0 +1,10 @@
+#pragma once
+
+#include "../common.h"
+
+// Skips surrounding whitespace without copying. Returns the first
+// non-space character and stores the trimmed length in `len`.
+const char *str_trim(const char *str, size_t *len);
+
+// Compares `len` bytes of `str` against the NUL-terminated `word`.
+bool str_equals_ignore_case(const char *str, size_t len, const char *word);
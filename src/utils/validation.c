@@ -0,0 +1,28 @@
+#include "validation.h"
+
+#define MAX_LABEL_LENGTH 63
+
+bool is_valid_hostname(const char *name) {
+  if (!name) return false;
+
+  size_t len = strlen(name);
+  if (len < MIN_URL_LENGTH || len > MAX_URL_LENGTH) return false;
+
+  size_t label_len = 0;
+  char prev = '.';
+
+  for (const char *c = name; *c; c++) {
+    if (*c == '.') {
+      if (label_len == 0 || prev == '-') return false;
+      label_len = 0;
+    } else if (isalnum((unsigned char) *c) || (*c == '-' && prev != '.')) {
+      if (++label_len > MAX_LABEL_LENGTH) return false;
+    } else {
+      return false;
+    }
+
+    prev = *c;
+  }
+
+  return label_len > 0 && prev != '-';
+}
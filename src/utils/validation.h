@@ -0,0 +1,8 @@
+#pragma once
+
+#include "../common.h"
+
+// RFC 1123 hostname: dot-separated labels of 1-63 letters, digits or
+// hyphens, not starting or ending with a hyphen, MIN_URL_LENGTH to
+// MAX_URL_LENGTH characters overall.
+bool is_valid_hostname(const char *name);
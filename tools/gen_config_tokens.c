@@ -0,0 +1,83 @@
+// Generates src/env/tokens/config_tokens_table.h: a collision-free
+// (perfect) hash table for every token in config_tokens.def.
+//
+//   gen_config_tokens > src/env/tokens/config_tokens_table.h
+
+#include "../src/env/tokens/config_tokens.h"
+
+#define MAX_SEED_ATTEMPTS 1000000u
+
+static const ConfigToken TOKENS[] = {
+#define CONFIG_TOKEN(text, kind, value) { text, sizeof(text) - 1, kind, value },
+#include "../src/env/tokens/config_tokens.def"
+#undef CONFIG_TOKEN
+};
+
+static const char *KIND_NAMES[] = {
+    [TOKEN_KIND_BOOL] = "TOKEN_KIND_BOOL",
+    [TOKEN_KIND_LOG_LEVEL] = "TOKEN_KIND_LOG_LEVEL",
+    [TOKEN_KIND_PROVIDER_FORMAT] = "TOKEN_KIND_PROVIDER_FORMAT",
+};
+
+static bool try_seed(uint32_t seed, uint32_t size, int *slots) {
+  for (uint32_t i = 0; i < size; i++) slots[i] = -1;
+
+  for (size_t i = 0; i < ARRAY_SIZE(TOKENS); i++) {
+    uint32_t slot = config_token_hash(TOKENS[i].text, TOKENS[i].length, seed) & (size - 1);
+
+    if (slots[slot] != -1) return false;
+    slots[slot] = (int) i;
+  }
+
+  return true;
+}
+
+int main(void) {
+  size_t max_length = 0;
+
+  for (size_t i = 0; i < ARRAY_SIZE(TOKENS); i++) {
+    for (size_t j = 0; j < TOKENS[i].length; j++) {
+      if (TOKENS[i].text[j] != tolower((unsigned char) TOKENS[i].text[j])) {
+        fprintf(stderr, "token \"%s\" must be lowercase\n", TOKENS[i].text);
+        return 1;
+      }
+    }
+
+    max_length = MAX(max_length, TOKENS[i].length);
+  }
+
+  // Smallest power of two with at most 50% load that admits a perfect seed.
+  for (uint32_t size = 2; size <= 4096; size <<= 1) {
+    if (size < 2 * ARRAY_SIZE(TOKENS)) continue;
+
+    int *slots = malloc(size * sizeof(int));
+    if (!slots) return 1;
+
+    for (uint32_t seed = 1; seed < MAX_SEED_ATTEMPTS; seed++) {
+      if (!try_seed(seed, size, slots)) continue;
+
+      printf("// Generated by tools/gen_config_tokens.c from config_tokens.def. Do not edit.\n");
+      printf("#pragma once\n\n");
+      printf("#define CONFIG_TOKEN_SEED 0x%08xu\n", seed);
+      printf("#define CONFIG_TOKEN_TABLE_SIZE %uu\n", size);
+      printf("#define CONFIG_TOKEN_MAX_LENGTH %zu\n\n", max_length);
+      printf("static const ConfigToken CONFIG_TOKEN_TABLE[CONFIG_TOKEN_TABLE_SIZE] = {\n");
+
+      for (uint32_t i = 0; i < size; i++) {
+        if (slots[i] < 0) continue;
+
+        const ConfigToken *t = &TOKENS[slots[i]];
+        printf("    [%u] = { \"%s\", %u, %s, %u },\n", i, t->text, t->length, KIND_NAMES[t->kind], t->value);
+      }
+
+      printf("};\n");
+      free(slots);
+      return 0;
+    }
+
+    free(slots);
+  }
+
+  fprintf(stderr, "no perfect seed found\n");
+  return 1;
+}